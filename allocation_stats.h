@@ -0,0 +1,459 @@
+#ifndef GENERAL_ALLOCATION_STATS_INCLUDE_H
+#define GENERAL_ALLOCATION_STATS_INCLUDE_H
+/*
+
+    Allocation statistics wrapper.
+
+    Wraps any Allocator and records allocation counts, bytes, live and
+    peak live bytes, a power of two size histogram and per-callsite
+    totals. Counters live in cache line padded per-thread slots, so
+    threads do not fight over them. Only the live byte total is shared,
+    the peak has to see frees from every thread.
+
+    Every block gets a small header with its size, so frees and resizes
+    are accounted exactly. The callsite is the return address of the
+    allocator proc. New and MemRealloc are forced inline, so for them it
+    is the line that used them. Containers allocate from their own code,
+    growing an Array shows up in array_reserve.
+
+    The counters are cache line aligned, allocate the stats aligned too.
+
+        Allocation_Stats *stats = NewAligned(Allocation_Stats, 64);
+        allocation_stats_init(stats, {heap_allocator, null}, "heap");
+
+        Allocator a = {allocation_stats_proc, stats};
+        ...
+        allocation_stats_dump(stats);
+
+
+    To include allocation stats implementation as cpp file use:
+
+    #define ALLOCATION_STATS_IMPLEMENTATION
+    #include "allocation_stats.h"
+
+*/
+
+#include "general.h"
+
+
+const s64 ALLOCATION_STATS_HEADER_SIZE    = 16;
+const s64 ALLOCATION_STATS_THREAD_SLOTS   = 64;    // Threads past this share slots.
+const s64 ALLOCATION_STATS_HISTOGRAM_SIZE = 40;    // Bucket n holds sizes below 2^n.
+const s64 ALLOCATION_STATS_CALLSITE_COUNT = 1024;  // Power of 2.
+
+typedef struct alignas(64) Allocation_Stats_Counters {  // Own cache lines per slot.
+    volatile s64 allocations;
+    volatile s64 resizes;
+    volatile s64 frees;
+
+    volatile s64 bytes_allocated;  // Growth through resizes counts too.
+    volatile s64 bytes_freed;      // And so does shrinking.
+
+    volatile s64 histogram[ALLOCATION_STATS_HISTOGRAM_SIZE];
+} Allocation_Stats_Counters;
+
+// Shared by every thread, hot callsites in many threads do contend here.
+typedef struct Allocation_Stats_Callsite {
+    void *volatile address;
+
+    volatile s64 allocations;
+    volatile s64 bytes_allocated;
+    volatile s64 live_bytes;
+} Allocation_Stats_Callsite;
+
+typedef struct Allocation_Stats {
+    Allocation_Stats_Counters threads[ALLOCATION_STATS_THREAD_SLOTS];
+    Allocation_Stats_Callsite callsites[ALLOCATION_STATS_CALLSITE_COUNT];
+
+    volatile s64 callsites_dropped = 0;  // Allocations from callsites that did not fit the table.
+    volatile s64 free_alls         = 0;
+
+    // Every thread updates these, the peak needs the live total across threads.
+    alignas(64) volatile s64 live_bytes = 0;
+    volatile s64 peak_live_bytes = 0;
+
+    const char *name = "";
+    Allocator inner  = {heap_allocator, null};
+} Allocation_Stats;
+
+// A summary over every thread slot.
+typedef struct Allocation_Stats_Report {
+    s64 allocations;
+    s64 resizes;
+    s64 frees;
+    s64 free_alls;
+
+    s64 bytes_allocated;
+    s64 bytes_freed;
+    s64 live_bytes;
+    s64 peak_live_bytes;
+
+    s64 histogram[ALLOCATION_STATS_HISTOGRAM_SIZE];
+} Allocation_Stats_Report;
+
+void allocation_stats_init(Allocation_Stats *stats, Allocator inner = {heap_allocator, null}, const char *name = "");
+
+TINYRT_EXTERN void allocation_stats_reset(Allocation_Stats *stats);
+TINYRT_EXTERN Allocation_Stats_Report allocation_stats_collect(Allocation_Stats *stats);
+
+// Prints the report and the callsites that allocated the most bytes.
+void allocation_stats_dump(Allocation_Stats *stats, s64 callsite_count = 16);
+
+TINYRT_EXTERN ALLOCATOR_PROC(allocation_stats_proc);
+
+#endif  // GENERAL_ALLOCATION_STATS_INCLUDE_H
+
+
+#if defined(ALLOCATION_STATS_IMPLEMENTATION) && !defined(ALLOCATION_STATS_IMPLEMENTATION_INCLUDED)
+#define ALLOCATION_STATS_IMPLEMENTATION_INCLUDED
+
+#if COMPILER_CL
+#define allocation_stats_return_address() _ReturnAddress()
+#else
+#define allocation_stats_return_address() __builtin_return_address(0)
+#endif
+
+#if OS_LINUX || OS_MAC
+#include <execinfo.h>
+#include <stdlib.h>
+#endif
+
+// Blocks handed out by the wrapper are prefixed by this header.
+typedef struct Allocation_Stats_Header {
+    s64 size;
+    s32 offset;           // From the inner block to the header, only set for aligned blocks.
+    s16 callsite;         // Index into callsites, -1 when it did not fit.
+    u16 alignment_shift;  // log2 of the alignment, only set for aligned blocks.
+} Allocation_Stats_Header;
+
+static_assert(ALLOCATION_STATS_CALLSITE_COUNT <= 32768, "Callsite indices have to fit the header.");
+
+static volatile s64 allocation_stats_next_slot = 0;
+static thread_var s64 allocation_stats_slot = -1;
+
+void allocation_stats_init(Allocation_Stats *stats, Allocator inner, const char *name) {
+    if (!inner.proc) {
+        inner.proc = heap_allocator;
+        inner.data = null;
+    }
+
+    // Slots would share cache lines otherwise, see NewAligned in the header comment.
+    assert(((umm)stats->threads % alignof(Allocation_Stats_Counters)) == 0);
+
+    stats->inner = inner;
+    stats->name  = name ? name : "";
+
+    allocation_stats_reset(stats);
+}
+
+TINYRT_EXTERN void allocation_stats_reset(Allocation_Stats *stats) {
+    memory_zero(stats->threads, size_of(stats->threads));
+    memory_zero(stats->callsites, size_of(stats->callsites));
+
+    stats->callsites_dropped = 0;
+    stats->free_alls         = 0;
+    stats->live_bytes        = 0;
+    stats->peak_live_bytes   = 0;
+}
+
+static inline Allocation_Stats_Counters *allocation_stats_counters(Allocation_Stats *stats) {
+    if (allocation_stats_slot < 0) {
+        allocation_stats_slot = atomic_fetch_add(&allocation_stats_next_slot, 1) % ALLOCATION_STATS_THREAD_SLOTS;
+    }
+
+    return &stats->threads[allocation_stats_slot];
+}
+
+static inline s64 allocation_stats_bucket(s64 size) {
+    if (size <= 0) return 0;
+
+#if COMPILER_CL
+    unsigned long index;
+    _BitScanReverse64(&index, (u64)size);
+    s64 result = (s64)index + 1;
+#else
+    s64 result = 64 - __builtin_clzll((u64)size);
+#endif
+
+    return Min(result, ALLOCATION_STATS_HISTOGRAM_SIZE - 1);
+}
+
+static void allocation_stats_grow(Allocation_Stats *stats, s64 bytes) {
+    Allocation_Stats_Counters *counters = allocation_stats_counters(stats);
+    atomic_fetch_add(&counters->bytes_allocated, bytes);
+
+    s64 live = atomic_fetch_add(&stats->live_bytes, bytes) + bytes;
+    while (true) {
+        s64 peak = atomic_load(&stats->peak_live_bytes);
+        if (live <= peak) break;
+        if (atomic_compare_and_swap(&stats->peak_live_bytes, peak, live)) break;
+    }
+}
+
+static void allocation_stats_shrink(Allocation_Stats *stats, s64 bytes) {
+    Allocation_Stats_Counters *counters = allocation_stats_counters(stats);
+    atomic_fetch_add(&counters->bytes_freed, bytes);
+    atomic_fetch_add(&stats->live_bytes, -bytes);
+}
+
+static s32 allocation_stats_callsite(Allocation_Stats *stats, void *address) {
+    s64 mask = ALLOCATION_STATS_CALLSITE_COUNT - 1;
+    s64 slot = (s64)(((u64)(umm)address * 11400714819323198485ull) >> 40) & mask;
+
+    for (s64 probe = 0; probe < 16; ++probe) {
+        Allocation_Stats_Callsite *it = &stats->callsites[slot];
+
+        void *current = atomic_load_pointer(&it->address);
+        if (current == address) return (s32)slot;
+
+        if (!current) {
+            if (atomic_compare_and_swap_pointer(&it->address, null, address)) return (s32)slot;
+            if (atomic_load_pointer(&it->address) == address) return (s32)slot;
+        }
+
+        slot = (slot + 1) & mask;
+    }
+
+    atomic_fetch_add(&stats->callsites_dropped, 1);
+    return -1;
+}
+
+static void *allocation_stats_get(Allocation_Stats *stats, s64 size, s64 alignment, void *address, bool zero = true) {
+    Allocator a = stats->inner;
+
+    u8 *block;
+    Allocation_Stats_Header *header;
+
+    if (alignment <= ALLOCATION_STATS_HEADER_SIZE) {
+        block = (u8 *)allocator_call(a, zero ? ALLOCATOR_ALLOCATE : ALLOCATOR_ALLOCATE_UNINITIALIZED, size + ALLOCATION_STATS_HEADER_SIZE);
+        if (!block) return null;
+
+        header = (Allocation_Stats_Header *)block;
+        header->offset          = 0;
+        header->alignment_shift = 0;
+    } else {
+        void *base;
+        block = (u8 *)allocator_alloc_aligned(a, size + alignment, alignment, &base);
+        if (!block) return null;
+
+        header = (Allocation_Stats_Header *)(block + alignment) - 1;
+        header->offset          = (s32)((u8 *)header - (u8 *)base);
+        header->alignment_shift = (u16)find_least_significant_set_bit((u32)alignment);
+    }
+
+    header->size     = size;
+    header->callsite = (s16)allocation_stats_callsite(stats, address);
+
+    Allocation_Stats_Counters *counters = allocation_stats_counters(stats);
+    atomic_fetch_add(&counters->allocations, 1);
+    atomic_fetch_add(&counters->histogram[allocation_stats_bucket(size)], 1);
+
+    if (header->callsite >= 0) {
+        Allocation_Stats_Callsite *callsite = &stats->callsites[header->callsite];
+        atomic_fetch_add(&callsite->allocations, 1);
+        atomic_fetch_add(&callsite->bytes_allocated, size);
+        atomic_fetch_add(&callsite->live_bytes, size);
+    }
+
+    allocation_stats_grow(stats, size);
+    return header + 1;
+}
+
+static void allocation_stats_put(Allocation_Stats *stats, void *memory) {
+    Allocation_Stats_Header *header = (Allocation_Stats_Header *)memory - 1;
+
+    Allocation_Stats_Counters *counters = allocation_stats_counters(stats);
+    atomic_fetch_add(&counters->frees, 1);
+    allocation_stats_shrink(stats, header->size);
+
+    if (header->callsite >= 0) {
+        atomic_fetch_add(&stats->callsites[header->callsite].live_bytes, -header->size);
+    }
+
+    Allocator a = stats->inner;
+    a.proc(ALLOCATOR_FREE, 0, 0, (u8 *)header - header->offset, a.data);
+}
+
+TINYRT_EXTERN Allocation_Stats_Report allocation_stats_collect(Allocation_Stats *stats) {
+    Allocation_Stats_Report result;
+    memory_zero(&result, size_of(result));
+
+    for (s64 index = 0; index < ALLOCATION_STATS_THREAD_SLOTS; ++index) {
+        Allocation_Stats_Counters *it = &stats->threads[index];
+
+        result.allocations     += atomic_load(&it->allocations);
+        result.resizes         += atomic_load(&it->resizes);
+        result.frees           += atomic_load(&it->frees);
+        result.bytes_allocated += atomic_load(&it->bytes_allocated);
+        result.bytes_freed     += atomic_load(&it->bytes_freed);
+
+        for (s64 bucket = 0; bucket < ALLOCATION_STATS_HISTOGRAM_SIZE; ++bucket) {
+            result.histogram[bucket] += atomic_load(&it->histogram[bucket]);
+        }
+    }
+
+    result.free_alls       = atomic_load(&stats->free_alls);
+    result.live_bytes      = atomic_load(&stats->live_bytes);
+    result.peak_live_bytes = Max(atomic_load(&stats->peak_live_bytes), result.live_bytes);
+    return result;
+}
+
+static s64 allocation_stats_compare_callsites(void *a, void *b) {
+    Allocation_Stats_Callsite *callsite_a = (Allocation_Stats_Callsite *)a;
+    Allocation_Stats_Callsite *callsite_b = (Allocation_Stats_Callsite *)b;
+
+    if (callsite_a->bytes_allocated == callsite_b->bytes_allocated) return 0;
+    return (callsite_a->bytes_allocated > callsite_b->bytes_allocated) ? -1 : 1;
+}
+
+void allocation_stats_dump(Allocation_Stats *stats, s64 callsite_count) {
+    Allocation_Stats_Report report = allocation_stats_collect(stats);
+
+    print("Allocation stats '%s':\n", stats->name);
+    print("    allocations %lld, resizes %lld, frees %lld, free alls %lld\n",
+          (long long)report.allocations, (long long)report.resizes, (long long)report.frees, (long long)report.free_alls);
+    print("    bytes allocated %lld, freed %lld, live %lld, peak live %lld\n",
+          (long long)report.bytes_allocated, (long long)report.bytes_freed, (long long)report.live_bytes, (long long)report.peak_live_bytes);
+
+    print("    sizes:\n");
+    for (s64 bucket = 0; bucket < ALLOCATION_STATS_HISTOGRAM_SIZE; ++bucket) {
+        if (!report.histogram[bucket]) continue;
+
+        s64 low = bucket ? ((s64)1 << (bucket - 1)) : 0;
+        print("        %12lld .. %-12lld %lld\n", (long long)low, (long long)(((s64)1 << bucket) - 1), (long long)report.histogram[bucket]);
+    }
+
+    // Sort a snapshot, the table itself keeps changing under other threads.
+    Allocation_Stats_Callsite *sorted = (Allocation_Stats_Callsite *)heap_alloc(size_of(stats->callsites));
+    if (!sorted) return;
+
+    s64 count = 0;
+    for (s64 index = 0; index < ALLOCATION_STATS_CALLSITE_COUNT; ++index) {
+        Allocation_Stats_Callsite *it = &stats->callsites[index];
+        if (!atomic_load_pointer(&it->address)) continue;
+
+        sorted[count].address         = it->address;
+        sorted[count].allocations     = atomic_load(&it->allocations);
+        sorted[count].bytes_allocated = atomic_load(&it->bytes_allocated);
+        sorted[count].live_bytes      = atomic_load(&it->live_bytes);
+        count += 1;
+    }
+
+    quick_sort(sorted, count, size_of(Allocation_Stats_Callsite), allocation_stats_compare_callsites);
+
+    print("    callsites (%lld, %lld allocations dropped):\n", (long long)count, (long long)atomic_load(&stats->callsites_dropped));
+    for (s64 index = 0; index < Min(count, callsite_count); ++index) {
+        Allocation_Stats_Callsite *it = &sorted[index];
+
+        print("        %p  allocations %lld, bytes %lld, live %lld",
+              it->address, (long long)it->allocations, (long long)it->bytes_allocated, (long long)it->live_bytes);
+
+#if OS_LINUX || OS_MAC
+        char **symbols = backtrace_symbols((void **)&it->address, 1);
+        if (symbols) {
+            print("  %s", symbols[0]);
+            free(symbols);
+        }
+#endif
+        print("\n");
+    }
+
+    heap_free(sorted);
+}
+
+TINYRT_EXTERN ALLOCATOR_PROC(allocation_stats_proc) {
+    Allocation_Stats *stats = (Allocation_Stats *)allocator_data;
+    assert(stats != null);
+    assert(stats->inner.proc != null);
+
+    Allocator a = stats->inner;
+
+    switch (mode) {
+        case ALLOCATOR_ALLOCATE:
+            return allocation_stats_get(stats, size, 0, allocation_stats_return_address());
+
+        case ALLOCATOR_ALLOCATE_ALIGNED:
+            return allocation_stats_get(stats, size, old_size, allocation_stats_return_address());
+
+        case ALLOCATOR_ALLOCATE_UNINITIALIZED:
+            return allocation_stats_get(stats, size, 0, allocation_stats_return_address(), false);
+
+        case ALLOCATOR_RESIZE: {
+            if (!old_memory) return allocation_stats_get(stats, size, 0, allocation_stats_return_address());
+
+            Allocation_Stats_Header *header = (Allocation_Stats_Header *)old_memory - 1;
+            s64 stored_size = header->size;
+
+            if (header->offset) {
+                // The inner allocator would not keep the alignment, move the block by hand.
+                void *result = allocation_stats_get(stats, size, (s64)1 << header->alignment_shift, allocation_stats_return_address());
+                if (!result) return null;
+
+                memcpy(result, old_memory, (umm)Min(stored_size, size));
+                allocation_stats_put(stats, old_memory);
+                return result;
+            }
+
+            header = (Allocation_Stats_Header *)a.proc(ALLOCATOR_RESIZE, size + ALLOCATION_STATS_HEADER_SIZE,
+                                                       stored_size + ALLOCATION_STATS_HEADER_SIZE, header, a.data);
+            if (!header) return null;
+
+            header->size = size;
+
+            Allocation_Stats_Counters *counters = allocation_stats_counters(stats);
+            atomic_fetch_add(&counters->resizes, 1);
+
+            if (header->callsite >= 0) {
+                Allocation_Stats_Callsite *callsite = &stats->callsites[header->callsite];
+                atomic_fetch_add(&callsite->live_bytes, size - stored_size);
+
+                // Growing containers are the hot spots, their growth counts like fresh bytes.
+                if (size > stored_size) atomic_fetch_add(&callsite->bytes_allocated, size - stored_size);
+            }
+
+            if (size > stored_size) {
+                allocation_stats_grow(stats, size - stored_size);
+            } else {
+                allocation_stats_shrink(stats, stored_size - size);
+            }
+
+            return header + 1;
+        } break;
+
+        case ALLOCATOR_FREE:
+            if (old_memory) allocation_stats_put(stats, old_memory);
+            return null;
+
+        case ALLOCATOR_FREE_ALL: {
+            a.proc(ALLOCATOR_FREE_ALL, 0, 0, null, a.data);
+
+            // Every block is gone at once, we only know the total.
+            atomic_fetch_add(&stats->free_alls, 1);
+            atomic_fetch_add(&stats->live_bytes, -atomic_load(&stats->live_bytes));
+
+            for (s64 index = 0; index < ALLOCATION_STATS_CALLSITE_COUNT; ++index) {
+                atomic_store(&stats->callsites[index].live_bytes, 0);
+            }
+
+            return null;
+        } break;
+
+        case ALLOCATOR_CAPS: {
+            // Blocks sit past our header, the inner usable size does not apply to them.
+            u32 caps = allocator_caps(a);
+            return (void *)(umm)(caps & ~(u32)ALLOCATOR_CAPS_USABLE_SIZE);
+        } break;
+
+        case ALLOCATOR_USABLE_SIZE:
+            return null;
+
+        default:
+            assert(false);
+            return null;
+    }
+}
+
+// Answers the modes past ALLOCATOR_ALLOCATE_ALIGNED, see allocator_call.
+static bool allocation_stats_declared = allocator_declare_extended_modes(allocation_stats_proc);
+
+#endif  // ALLOCATION_STATS_IMPLEMENTATION
@@ -0,0 +1,556 @@
+#ifndef GENERAL_ALLOCATION_TRACE_INCLUDE_H
+#define GENERAL_ALLOCATION_TRACE_INCLUDE_H
+/*
+
+    Allocation trace recorder and replay.
+
+    allocation_trace_proc wraps any Allocator and writes every call to a
+    compact binary file, one fixed size event per call. Blocks are named
+    by ids instead of pointers, so a trace can be replayed against any
+    other Allocator with allocation_trace_replay.
+
+    Recording serializes the wrapped allocator behind a lock, so events
+    land in the file in the order they happened. Replay runs the events
+    on one thread in that same order.
+
+        Allocation_Trace trace;
+        allocation_trace_open(&trace, "app.trace", {heap_allocator, null});
+
+        Allocator a = {allocation_trace_proc, &trace};
+        ...
+        allocation_trace_close(&trace);
+
+    benchmarks/trace_replay.cpp replays a trace file against the
+    allocators of this repository.
+
+
+    To include allocation trace implementation as cpp file use:
+
+    #define ALLOCATION_TRACE_IMPLEMENTATION
+    #include "allocation_trace.h"
+
+*/
+
+#include "general.h"
+
+
+const u32 ALLOCATION_TRACE_MAGIC       = 0x43525441;  // "ATRC"
+const u32 ALLOCATION_TRACE_VERSION     = 1;
+const s64 ALLOCATION_TRACE_BUFFER_SIZE = 4096;  // Events written per flush.
+
+typedef struct Allocation_Trace_Event {
+    u64 timestamp;  // Nanoseconds since the trace was opened.
+    s64 size;
+    s64 old_size;   // The alignment for ALLOCATOR_ALLOCATE_ALIGNED.
+    u32 id;         // Block the call works on, 0 for none.
+    u16 thread;     // Order in which threads first used the trace.
+    u8  mode;       // Allocator_Mode.
+    u8  failed;     // The wrapped allocator returned null.
+} Allocation_Trace_Event;
+
+typedef struct Allocation_Trace_File_Header {
+    u32 magic;
+    u32 version;
+    u32 event_size;
+    u32 padding;
+} Allocation_Trace_File_Header;
+
+typedef struct Allocation_Trace {
+    void *file = null;  // FILE *.
+
+    Spin_Lock lock = {0};
+
+    Allocation_Trace_Event *events = null;  // Buffered until the next flush.
+    s64 event_count    = 0;
+    s64 events_written = 0;
+
+    u64 start_time = 0;
+    u32 next_id    = 1;
+
+    // Open addressing map from live pointers to their ids.
+    void **map_pointers = null;
+    u32 *map_ids        = null;
+    s64 map_capacity    = 0;
+    s64 map_count       = 0;
+
+    Allocator inner = {heap_allocator, null};
+} Allocation_Trace;
+
+typedef struct Allocation_Trace_Replay_Result {
+    s64 events;
+    float64 seconds;  // Without the time spent sampling the resident size.
+
+    s64 peak_live_bytes;      // Most bytes requested and not freed at once.
+    s64 peak_resident_bytes;  // Growth of the process over the replay, 0 if unknown.
+    float64 fragmentation;    // peak_resident_bytes / peak_live_bytes, 0 if unknown.
+
+    s64 failed;  // Calls that returned null although they did not while recording.
+} Allocation_Trace_Replay_Result;
+
+TINYRT_EXTERN bool allocation_trace_open(Allocation_Trace *trace, const char *file_name, Allocator inner);
+TINYRT_EXTERN void allocation_trace_flush(Allocation_Trace *trace);
+TINYRT_EXTERN void allocation_trace_close(Allocation_Trace *trace);
+
+// Returns heap memory with every event of the file, null if it can not be read.
+TINYRT_EXTERN Allocation_Trace_Event *allocation_trace_load(const char *file_name, s64 *count_return);
+
+// With touch_memory set, one byte of every page of a new block gets written,
+// so resident memory behaves like a program that uses what it allocates.
+Allocation_Trace_Replay_Result allocation_trace_replay(Allocation_Trace_Event *events, s64 count, Allocator a, bool touch_memory = true);
+
+TINYRT_EXTERN ALLOCATOR_PROC(allocation_trace_proc);
+
+#endif  // GENERAL_ALLOCATION_TRACE_INCLUDE_H
+
+
+#if defined(ALLOCATION_TRACE_IMPLEMENTATION) && !defined(ALLOCATION_TRACE_IMPLEMENTATION_INCLUDED)
+#define ALLOCATION_TRACE_IMPLEMENTATION_INCLUDED
+
+#include <stdio.h>
+
+#if OS_WINDOWS
+#ifdef INCLUDE_WINDEFS
+#include "windefs.h"
+#else
+#define WIN32_LEAN_AND_MEAN
+#define VC_EXTRALEAN
+#include <windows.h>
+#endif
+#else
+#include <time.h>
+#endif
+
+static volatile s64 allocation_trace_next_thread = 0;
+static thread_var s64 allocation_trace_thread = -1;
+
+static u64 allocation_trace_now(void) {
+#if OS_WINDOWS
+    static LARGE_INTEGER frequency;
+    if (!frequency.QuadPart) QueryPerformanceFrequency(&frequency);
+
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return (u64)((float64)counter.QuadPart * 1e9 / (float64)frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000000ull + (u64)ts.tv_nsec;
+#endif
+}
+
+// Resident memory of the process, 0 where we do not know how to get it.
+static s64 allocation_trace_resident_bytes(void) {
+#if OS_LINUX
+    FILE *file = fopen("/proc/self/statm", "r");
+    if (!file) return 0;
+
+    long long total = 0, resident = 0;
+    int matched = fscanf(file, "%lld %lld", &total, &resident);
+    fclose(file);
+
+    if (matched != 2) return 0;
+    return (s64)resident * os_get_page_size();
+#else
+    return 0;
+#endif
+}
+
+TINYRT_EXTERN bool allocation_trace_open(Allocation_Trace *trace, const char *file_name, Allocator inner) {
+    if (!inner.proc) {
+        inner.proc = heap_allocator;
+        inner.data = null;
+    }
+
+    FILE *file = fopen(file_name, "wb");
+    if (!file) return false;
+
+    Allocation_Trace_File_Header header;
+    header.magic      = ALLOCATION_TRACE_MAGIC;
+    header.version    = ALLOCATION_TRACE_VERSION;
+    header.event_size = (u32)size_of(Allocation_Trace_Event);
+    header.padding    = 0;
+
+    if (fwrite(&header, size_of(header), 1, file) != 1) {
+        fclose(file);
+        return false;
+    }
+
+    trace->file   = file;
+    trace->events = (Allocation_Trace_Event *)heap_alloc(ALLOCATION_TRACE_BUFFER_SIZE * size_of(Allocation_Trace_Event));
+    if (!trace->events) {
+        fclose(file);
+        trace->file = null;
+        return false;
+    }
+
+    trace->lock.locked    = 0;
+    trace->event_count    = 0;
+    trace->events_written = 0;
+
+    trace->start_time = allocation_trace_now();
+    trace->next_id    = 1;
+
+    trace->map_pointers = null;
+    trace->map_ids      = null;
+    trace->map_capacity = 0;
+    trace->map_count    = 0;
+
+    trace->inner = inner;
+    return true;
+}
+
+static void allocation_trace_flush_locked(Allocation_Trace *trace) {
+    if (!trace->file || !trace->event_count) return;
+
+    fwrite(trace->events, size_of(Allocation_Trace_Event), (size_t)trace->event_count, (FILE *)trace->file);
+
+    trace->events_written += trace->event_count;
+    trace->event_count = 0;
+}
+
+TINYRT_EXTERN void allocation_trace_flush(Allocation_Trace *trace) {
+    spin_lock(&trace->lock);
+    allocation_trace_flush_locked(trace);
+    if (trace->file) fflush((FILE *)trace->file);
+    spin_unlock(&trace->lock);
+}
+
+TINYRT_EXTERN void allocation_trace_close(Allocation_Trace *trace) {
+    spin_lock(&trace->lock);
+
+    allocation_trace_flush_locked(trace);
+    if (trace->file) fclose((FILE *)trace->file);
+    trace->file = null;
+
+    if (trace->events) heap_free(trace->events);
+    if (trace->map_pointers) heap_free(trace->map_pointers);
+    if (trace->map_ids) heap_free(trace->map_ids);
+
+    trace->events       = null;
+    trace->map_pointers = null;
+    trace->map_ids      = null;
+    trace->map_capacity = 0;
+    trace->map_count    = 0;
+
+    spin_unlock(&trace->lock);
+}
+
+static inline s64 allocation_trace_slot(void *pointer, s64 capacity) {
+    return (s64)(((u64)(umm)pointer * 11400714819323198485ull) >> 32) & (capacity - 1);
+}
+
+static void allocation_trace_map_insert(Allocation_Trace *trace, void *pointer, u32 id) {
+    if ((trace->map_count + 1) * 2 > trace->map_capacity) {
+        // Keep the load factor under one half.
+        s64 old_capacity   = trace->map_capacity;
+        void **old_pointers = trace->map_pointers;
+        u32 *old_ids        = trace->map_ids;
+
+        s64 new_capacity = old_capacity ? old_capacity * 2 : 1024;
+
+        trace->map_pointers = (void **)heap_alloc(new_capacity * size_of(void *));
+        trace->map_ids      = (u32 *)heap_alloc(new_capacity * size_of(u32));
+        trace->map_capacity = new_capacity;
+        assert(trace->map_pointers && trace->map_ids);
+
+        for (s64 index = 0; index < old_capacity; ++index) {
+            if (!old_pointers[index]) continue;
+
+            s64 slot = allocation_trace_slot(old_pointers[index], new_capacity);
+            while (trace->map_pointers[slot]) slot = (slot + 1) & (new_capacity - 1);
+
+            trace->map_pointers[slot] = old_pointers[index];
+            trace->map_ids[slot]      = old_ids[index];
+        }
+
+        if (old_pointers) heap_free(old_pointers);
+        if (old_ids) heap_free(old_ids);
+    }
+
+    s64 slot = allocation_trace_slot(pointer, trace->map_capacity);
+    while (trace->map_pointers[slot]) slot = (slot + 1) & (trace->map_capacity - 1);
+
+    trace->map_pointers[slot] = pointer;
+    trace->map_ids[slot]      = id;
+    trace->map_count += 1;
+}
+
+// Returns the id of pointer and takes it out of the map, 0 if it was not there.
+static u32 allocation_trace_map_remove(Allocation_Trace *trace, void *pointer) {
+    if (!trace->map_capacity) return 0;
+
+    s64 mask = trace->map_capacity - 1;
+    s64 slot = allocation_trace_slot(pointer, trace->map_capacity);
+
+    while (trace->map_pointers[slot] != pointer) {
+        if (!trace->map_pointers[slot]) return 0;
+        slot = (slot + 1) & mask;
+    }
+
+    u32 result = trace->map_ids[slot];
+
+    // Shift the rest of the cluster back so lookups never need tombstones.
+    s64 hole = slot;
+    s64 next = (slot + 1) & mask;
+    while (trace->map_pointers[next]) {
+        s64 home = allocation_trace_slot(trace->map_pointers[next], trace->map_capacity);
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            trace->map_pointers[hole] = trace->map_pointers[next];
+            trace->map_ids[hole]      = trace->map_ids[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+
+    trace->map_pointers[hole] = null;
+    trace->map_count -= 1;
+    return result;
+}
+
+static void allocation_trace_record(Allocation_Trace *trace, Allocator_Mode mode, s64 size, s64 old_size, u32 id, bool failed) {
+    if (allocation_trace_thread < 0) allocation_trace_thread = atomic_fetch_add(&allocation_trace_next_thread, 1);
+
+    if (trace->event_count == ALLOCATION_TRACE_BUFFER_SIZE) allocation_trace_flush_locked(trace);
+
+    Allocation_Trace_Event *event = &trace->events[trace->event_count];
+    trace->event_count += 1;
+
+    event->timestamp = allocation_trace_now() - trace->start_time;
+    event->size      = size;
+    event->old_size  = old_size;
+    event->id        = id;
+    event->thread    = (u16)allocation_trace_thread;
+    event->mode      = (u8)mode;
+    event->failed    = failed ? 1 : 0;
+}
+
+TINYRT_EXTERN ALLOCATOR_PROC(allocation_trace_proc) {
+    Allocation_Trace *trace = (Allocation_Trace *)allocator_data;
+    assert(trace != null);
+    assert(trace->inner.proc != null);
+
+    Allocator a = trace->inner;
+
+    spin_lock(&trace->lock);
+
+    void *result = allocator_call(a, mode, size, old_size, old_memory);
+
+    // Closed, calls still go through but nothing is kept about them.
+    if (!trace->events) {
+        spin_unlock(&trace->lock);
+        return result;
+    }
+
+    switch (mode) {
+        case ALLOCATOR_ALLOCATE:
+        case ALLOCATOR_ALLOCATE_ALIGNED:
+        case ALLOCATOR_ALLOCATE_UNINITIALIZED: {
+            u32 id = 0;
+            if (result) {
+                id = trace->next_id++;
+                allocation_trace_map_insert(trace, result, id);
+            }
+
+            allocation_trace_record(trace, mode, size, old_size, id, !result);
+        } break;
+
+        case ALLOCATOR_RESIZE: {
+            // The block keeps its id when it moves.
+            u32 id = old_memory ? allocation_trace_map_remove(trace, old_memory) : 0;
+
+            if (result) {
+                if (!id) id = trace->next_id++;
+                allocation_trace_map_insert(trace, result, id);
+            } else if (id) {
+                allocation_trace_map_insert(trace, old_memory, id);
+            }
+
+            allocation_trace_record(trace, mode, size, old_size, id, !result && size);
+        } break;
+
+        case ALLOCATOR_FREE: {
+            u32 id = old_memory ? allocation_trace_map_remove(trace, old_memory) : 0;
+            allocation_trace_record(trace, mode, 0, 0, id, false);
+        } break;
+
+        case ALLOCATOR_FREE_ALL: {
+            if (trace->map_capacity) memory_zero(trace->map_pointers, (umm)(trace->map_capacity * size_of(void *)));
+            trace->map_count = 0;
+
+            allocation_trace_record(trace, mode, 0, 0, 0, false);
+        } break;
+
+        case ALLOCATOR_CAPS:
+        case ALLOCATOR_USABLE_SIZE:
+            // Queries do not change the heap, they are not recorded.
+            break;
+
+        default:
+            assert(false);
+            break;
+    }
+
+    spin_unlock(&trace->lock);
+    return result;
+}
+
+// Answers the modes past ALLOCATOR_ALLOCATE_ALIGNED, see allocator_call.
+static bool allocation_trace_declared = allocator_declare_extended_modes(allocation_trace_proc);
+
+TINYRT_EXTERN Allocation_Trace_Event *allocation_trace_load(const char *file_name, s64 *count_return) {
+    *count_return = 0;
+
+    FILE *file = fopen(file_name, "rb");
+    if (!file) return null;
+
+    Allocation_Trace_File_Header header;
+    bool valid = (fread(&header, size_of(header), 1, file) == 1) &&
+                 (header.magic == ALLOCATION_TRACE_MAGIC) &&
+                 (header.version == ALLOCATION_TRACE_VERSION) &&
+                 (header.event_size == size_of(Allocation_Trace_Event));
+
+    fseek(file, 0, SEEK_END);
+    s64 file_size = (s64)ftell(file);
+    fseek(file, size_of(header), SEEK_SET);
+
+    s64 count = (file_size - (s64)size_of(header)) / (s64)size_of(Allocation_Trace_Event);
+    if (!valid || (count <= 0)) {
+        fclose(file);
+        return null;
+    }
+
+    Allocation_Trace_Event *result = (Allocation_Trace_Event *)heap_alloc(count * size_of(Allocation_Trace_Event));
+    if (result) count = (s64)fread(result, size_of(Allocation_Trace_Event), (size_t)count, file);
+
+    fclose(file);
+
+    *count_return = result ? count : 0;
+    return result;
+}
+
+static void allocation_trace_touch(u8 *memory, s64 from, s64 to) {
+    s64 page_size = os_get_page_size();
+
+    for (s64 offset = from; offset < to; offset = align_forward(offset + 1, page_size)) {
+        ((volatile u8 *)memory)[offset] = 1;
+    }
+}
+
+Allocation_Trace_Replay_Result allocation_trace_replay(Allocation_Trace_Event *events, s64 count, Allocator a, bool touch_memory) {
+    Allocation_Trace_Replay_Result result;
+    memory_zero(&result, size_of(result));
+
+    u32 id_count = 1;
+    for (s64 index = 0; index < count; ++index) id_count = Max(id_count, events[index].id + 1);
+
+    void **blocks = (void **)heap_alloc(id_count * size_of(void *));
+    s64 *sizes    = (s64 *)heap_alloc(id_count * size_of(s64));
+    assert(blocks && sizes);
+
+    s64 live = 0;
+    s64 resident_start = allocation_trace_resident_bytes();
+    s64 resident_peak  = resident_start;
+
+    u64 start    = allocation_trace_now();
+    u64 sampling = 0;  // Taken out of the replay time.
+
+    for (s64 index = 0; index < count; ++index) {
+        Allocation_Trace_Event *it = &events[index];
+        Allocator_Mode mode = (Allocator_Mode)it->mode;
+
+        switch (mode) {
+            case ALLOCATOR_ALLOCATE:
+            case ALLOCATOR_ALLOCATE_ALIGNED:
+            case ALLOCATOR_ALLOCATE_UNINITIALIZED: {
+                if (!it->id) break;
+
+                u8 *memory = (u8 *)allocator_call(a, mode, it->size, it->old_size);
+                if (!memory) {
+                    result.failed += 1;
+                    break;
+                }
+
+                if (touch_memory) allocation_trace_touch(memory, 0, it->size);
+
+                blocks[it->id] = memory;
+                sizes[it->id]  = it->size;
+                live += it->size;
+            } break;
+
+            case ALLOCATOR_RESIZE: {
+                if (!it->id || it->failed) break;
+
+                s64 old_size = blocks[it->id] ? sizes[it->id] : 0;
+
+                u8 *memory = (u8 *)a.proc(ALLOCATOR_RESIZE, it->size, old_size, blocks[it->id], a.data);
+                if (!memory && it->size) {
+                    result.failed += 1;
+                    break;
+                }
+
+                if (touch_memory && memory && (it->size > old_size)) allocation_trace_touch(memory, old_size, it->size);
+
+                blocks[it->id] = memory;
+                sizes[it->id]  = it->size;
+                live += it->size - old_size;
+            } break;
+
+            case ALLOCATOR_FREE: {
+                if (!it->id || !blocks[it->id]) break;
+
+                a.proc(ALLOCATOR_FREE, 0, 0, blocks[it->id], a.data);
+                live -= sizes[it->id];
+
+                blocks[it->id] = null;
+                sizes[it->id]  = 0;
+            } break;
+
+            case ALLOCATOR_FREE_ALL: {
+                // Allocators without ALLOCATOR_FREE_ALL get every live block freed instead.
+                if (allocator_caps(a) & ALLOCATOR_CAPS_FREE_ALL) {
+                    a.proc(ALLOCATOR_FREE_ALL, 0, 0, null, a.data);
+                } else {
+                    for (u32 id = 1; id < id_count; ++id) {
+                        if (blocks[id]) a.proc(ALLOCATOR_FREE, 0, 0, blocks[id], a.data);
+                    }
+                }
+
+                memory_zero(blocks, (umm)(id_count * size_of(void *)));
+                memory_zero(sizes, (umm)(id_count * size_of(s64)));
+                live = 0;
+            } break;
+
+            default:
+                break;
+        }
+
+        result.peak_live_bytes = Max(result.peak_live_bytes, live);
+
+        // Reading the resident size is a system call, only sample it.
+        if ((index & 4095) == 4095) {
+            u64 sample_start = allocation_trace_now();
+            resident_peak = Max(resident_peak, allocation_trace_resident_bytes());
+            sampling += allocation_trace_now() - sample_start;
+        }
+    }
+
+    result.seconds = (float64)(allocation_trace_now() - start - sampling) / 1e9;
+    result.events  = count;
+
+    resident_peak = Max(resident_peak, allocation_trace_resident_bytes());
+    if (resident_start) {
+        result.peak_resident_bytes = resident_peak - resident_start;
+        if (result.peak_live_bytes) result.fragmentation = (float64)result.peak_resident_bytes / (float64)result.peak_live_bytes;
+    }
+
+    // Hand back what the trace never freed.
+    for (u32 id = 1; id < id_count; ++id) {
+        if (blocks[id]) a.proc(ALLOCATOR_FREE, 0, 0, blocks[id], a.data);
+    }
+
+    heap_free(blocks);
+    heap_free(sizes);
+    return result;
+}
+
+#endif  // ALLOCATION_TRACE_IMPLEMENTATION
@@ -3,6 +3,21 @@
 // I want to keep this separate from the general layer.
 #include "general.h"
 
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// How an array grows when array_add runs out of room.
+typedef struct Array_Growth {
+    s64 percent          = 200;       // New capacity in percent of the old one.
+    s64 minimum_count    = 8;
+    s64 page_round_bytes = KB(64);    // Bigger capacities round up to whole pages, 0 never rounds.
+    s64 maximum_count    = -1;        // Hard cap, adding past it fails. -1 for none.
+} Array_Growth;
+
+const Array_Growth ARRAY_GROWTH_DEFAULT = {};
+const Array_Growth ARRAY_GROWTH_HALF    = {150, 8, KB(64), -1};  // Wastes less on big arrays, copies more often.
+
 template<typename T>
 struct Array {
     s64 allocated = 0;
@@ -11,14 +26,97 @@ struct Array {
     
     Allocator allocator = {heap_allocator, null};
 
+    const Array_Growth *growth = null;  // null grows like ARRAY_GROWTH_DEFAULT.
+
     TINYRT_INLINE T &operator[] (s64 index) {
         assert(index >= 0);
         assert(index < this->count);
         assert(this->data != null);
         return this->data[index];
     }
+
+    // for (auto &it : array), see For.
+    TINYRT_INLINE T *begin() { return this->data; }
+    TINYRT_INLINE T *end()   { return this->data + this->count; }
 };
 
+#define For(array) for (auto &it : (array))
+
+// Non owning view of count items at data, for Arrays, C arrays, Strings and
+// parts of them. Passing a view never copies the items.
+template<typename T>
+struct Array_View {
+    s64 count = 0;
+    T *data   = null;
+
+    Array_View() {}
+    Array_View(Array<T> &array) : count(array.count), data(array.data) {}
+    Array_View(Array<T> *array) : count(array->count), data(array->data) {}
+
+    template<s64 N>
+    Array_View(T (&items)[N]) : count(N), data(items) {}
+
+    // Only for Array_View<u8>.
+    template<typename U = T, typename = typename std::enable_if<std::is_same<U, u8>::value>::type>
+    Array_View(String s) : count(s.count), data(s.data) {}
+
+    TINYRT_INLINE T &operator[] (s64 index) const {
+        assert(index >= 0);
+        assert(index < this->count);
+        return this->data[index];
+    }
+
+    TINYRT_INLINE T *begin() const { return this->data; }
+    TINYRT_INLINE T *end()   const { return this->data + this->count; }
+};
+
+// Views for template calls, the implicit conversions do not take part in deduction.
+template<typename T>
+TINYRT_INLINE Array_View<T> array_view(T *data, s64 count) {
+    Array_View<T> result;
+    result.count = count;
+    result.data  = data;
+    return result;
+}
+
+template<typename T>
+TINYRT_INLINE Array_View<T> array_view(Array<T> *array) {
+    return Array_View<T>(array);
+}
+
+template<typename T, s64 N>
+TINYRT_INLINE Array_View<T> array_view(T (&items)[N]) {
+    return Array_View<T>(items);
+}
+
+inline Array_View<u8> array_view(String s) {
+    return Array_View<u8>(s);
+}
+
+// Trivially copyable items go around as bytes, through ALLOCATOR_RESIZE and
+// memcpy. Anything else (items with constructors, destructors, owned memory)
+// is constructed in place, moved when the array grows and destroyed when it
+// leaves the array. Memory past count is raw either way.
+template<typename T>
+constexpr bool array_items_are_trivial(void) {
+    return std::is_trivially_copyable<T>::value;
+}
+
+template<typename T>
+TINYRT_INLINE void array_destroy_items(T *items, s64 count) {
+    if (std::is_trivially_destructible<T>::value) return;
+
+    for (s64 index = 0; index < count; ++index) items[index].~T();
+}
+
+// Index of item if it lives in the array, -1 otherwise. Growing moves the
+// items, so references into the array have to be taken again after that.
+template<typename T>
+TINYRT_INLINE s64 array_index_of_pointer(Array<T> *arr, const T *item) {
+    if (!arr->data || (item < arr->data) || (item >= arr->data + arr->count)) return -1;
+    return item - arr->data;
+}
+
 template<typename T>
 Array<T> array_new(s64 n, Allocator a = {heap_allocator, null}) {
     Array<T> result = {};
@@ -35,12 +133,43 @@ Array<T> array_new(s64 n, Allocator a = {heap_allocator, null}) {
 
     result.data = (T *)a.proc(ALLOCATOR_ALLOCATE, n * size_of(T), 0, null, a.data);
 
+    if (!array_items_are_trivial<T>() && result.data) {
+        for (s64 index = 0; index < n; ++index) new (result.data + index) T();
+    }
+
+    return result;
+}
+
+// Like array_new, but the items hold garbage until they are written.
+// Items that are not trivially copyable are default constructed.
+template<typename T>
+Array<T> array_new_uninitialized(s64 n, Allocator a = {heap_allocator, null}) {
+    Array<T> result = {};
+
+    if (!a.proc) {
+        a.proc = heap_allocator;
+        a.data = null;
+    }
+
+    result.allocator = a;
+
+    result.allocated = n;
+    result.count     = n;
+
+    result.data = (T *)allocator_call(a, ALLOCATOR_ALLOCATE_UNINITIALIZED, n * size_of(T));
+
+    if (!array_items_are_trivial<T>() && result.data) {
+        for (s64 index = 0; index < n; ++index) new (result.data + index) T;
+    }
+
     return result;
 }
 
 template<typename T>
 void array_free(Array<T> *arr) {
     if (arr->data) {
+        array_destroy_items(arr->data, arr->count);
+
         Allocator a = arr->allocator;
         
         if (!a.proc) {
@@ -58,13 +187,30 @@ void array_free(Array<T> *arr) {
 
 template<typename T>
 TINYRT_INLINE void array_reset(Array<T> *arr) {
+    array_destroy_items(arr->data, arr->count);
     arr->count = 0;
 }
 
+// Copies only the items of src, which can be any part of another array. It
+// can be a part of dest itself for trivially copyable items.
 template<typename T>
-void array_copy(Array<T> *dest, Array<T> *src) {
-    if (dest->allocated < src->count) {
-        dest->allocated = src->count;
+void array_copy(Array<T> *dest, Array_View<T> src) {
+    if (!array_items_are_trivial<T>()) {
+        // The items of dest go first, src must not be one of them.
+        assert((src.data + src.count <= dest->data) || (src.data >= dest->data + dest->count) || !src.count);
+
+        array_reset(dest);
+        array_reserve(dest, src.count);
+        if (dest->allocated < src.count) return;
+
+        for (s64 index = 0; index < src.count; ++index) new (dest->data + index) T(src.data[index]);
+        dest->count = src.count;
+        return;
+    }
+
+    // A part of dest always fits in it, the block is only replaced for other sources.
+    if (dest->allocated < src.count) {
+        dest->allocated = src.count;
 
         Allocator a = dest->allocator;
         
@@ -79,11 +225,63 @@ void array_copy(Array<T> *dest, Array<T> *src) {
         if (dest->data)
             a.proc(ALLOCATOR_FREE, 0, 0, dest->data, a.data);
         
-        dest->data = (T *)a.proc(ALLOCATOR_ALLOCATE, src->count * size_of(T), 0, null, a.data);
+        dest->data = (T *)allocator_call(a, ALLOCATOR_ALLOCATE_UNINITIALIZED, src.count * size_of(T));
+    }
+
+    dest->count = src.count;
+    if (src.count) memmove((void *)dest->data, src.data, (umm)(src.count * size_of(T)));
+}
+
+template<typename T>
+void array_copy(Array<T> *dest, Array<T> *src) {
+    array_copy(dest, array_view(src));
+}
+
+// Items a block of usable_bytes holds. The allocator may round the block
+// past maximum_count, the capacity stays at the cap so adds still fail there.
+template<typename T>
+s64 array_capacity_for_bytes(Array<T> *arr, s64 usable_bytes) {
+    s64 result = usable_bytes / size_of(T);
+
+    if (arr->growth && (arr->growth->maximum_count >= 0)) {
+        result = Min(result, Max(arr->growth->maximum_count, arr->count));
+    }
+
+    return result;
+}
+
+// Moves the items into a fresh block with room for capacity items, for items
+// that can not go through ALLOCATOR_RESIZE. Items past capacity are
+// destroyed. False, with the array untouched, if the allocation fails.
+template<typename T>
+bool array_move_to_new_block(Array<T> *arr, s64 capacity) {
+    if (!arr->allocator.proc) {
+        arr->allocator.proc = heap_allocator;
+        arr->allocator.data = null;
+    }
+
+    Allocator a = arr->allocator;
+
+    s64 num_bytes = capacity * size_of(T);
+
+    T *new_data = null;
+    if (capacity) {
+        new_data = (T *)allocator_call(a, ALLOCATOR_ALLOCATE_UNINITIALIZED, num_bytes);
+        if (!new_data) return false;
+    }
+
+    s64 moved = Min(arr->count, capacity);
+    for (s64 index = 0; index < moved; ++index) new (new_data + index) T(std::move(arr->data[index]));
+
+    if (arr->data) {
+        array_destroy_items(arr->data, arr->count);
+        a.proc(ALLOCATOR_FREE, 0, 0, arr->data, a.data);
     }
 
-    dest->count = src->count;
-    memcpy(dest->data, src->data, (umm)(src->count * size_of(T)));
+    arr->data      = new_data;
+    arr->count     = moved;
+    arr->allocated = new_data ? array_capacity_for_bytes(arr, allocator_usable_size(new_data, num_bytes, a)) : 0;
+    return true;
 }
 
 template<typename T>
@@ -101,51 +299,432 @@ void array_reserve(Array<T> *arr, s64 reserve) {
 
     Allocator a = arr->allocator;
 
-    void *new_memory = a.proc(ALLOCATOR_RESIZE, num_bytes, arr->count * size, arr->data, a.data);
+    if (!array_items_are_trivial<T>()) {
+        bool moved = array_move_to_new_block(arr, reserve);
+        assert(moved);
+        UNUSED(moved);
+        return;
+    }
+
+    // Nothing past count is ever read before it is written, so a first
+    // allocation does not need zeroing.
+    void *new_memory;
+    if (arr->data) {
+        new_memory = a.proc(ALLOCATOR_RESIZE, num_bytes, arr->count * size, arr->data, a.data);
+    } else {
+        new_memory = allocator_call(a, ALLOCATOR_ALLOCATE_UNINITIALIZED, num_bytes);
+    }
     assert(new_memory != null);
 
     if (!new_memory) return;
 
+    // Take whatever the allocator rounded the block up to, so the next
+    // array_add does not regrow into memory we already own.
+    s64 usable = allocator_usable_size(new_memory, num_bytes, a);
+
     arr->data = (T *)new_memory;
-    arr->allocated = reserve;
+    arr->allocated = array_capacity_for_bytes(arr, usable);
+}
+
+// Capacity for at least needed items of item_size bytes, following growth (null for
+// the default). Never more than maximum_count, so the result can be short of needed.
+inline s64 array_growth_next_capacity(const Array_Growth *growth, s64 allocated, s64 needed, s64 item_size) {
+    if (!growth) growth = &ARRAY_GROWTH_DEFAULT;
+
+    s64 result = allocated * growth->percent / 100;
+    result = Max(result, allocated + 1);
+    result = Max(result, growth->minimum_count);
+    result = Max(result, needed);
+
+    s64 bytes = result * item_size;
+    if (growth->page_round_bytes && (bytes >= growth->page_round_bytes)) {
+        result = align_forward(bytes, os_get_page_size()) / item_size;
+    }
+
+    if (growth->maximum_count >= 0) result = Min(result, growth->maximum_count);
+    return result;
 }
 
+// Capacity for at least needed items, following the growth policy of the array.
 template<typename T>
-void array_add(Array<T> *arr, T item) {
-    if (arr->count >= arr->allocated) {
-        s64 reserve_count = 2 * arr->allocated;
-        if (reserve_count < 8) reserve_count = 8;
+s64 array_next_capacity(Array<T> *arr, s64 needed) {
+    return array_growth_next_capacity(arr->growth, arr->allocated, needed, size_of(T));
+}
+
+// Makes room for count more items, false if the array can not grow that far.
+template<typename T>
+bool array_grow(Array<T> *arr, s64 count) {
+    s64 needed = arr->count + count;
+    if (needed <= arr->allocated) return true;
 
-        array_reserve(arr, reserve_count);
+    s64 capacity = array_next_capacity(arr, needed);
+    if (capacity < needed) {
+        write_string("Panic: Array grows past its maximum_count.\n", /*bool to_standard_error=*/true);
+        assert(0);
+        return false;
     }
 
-    arr->data[arr->count] = item;
-    arr->count += 1;
+    array_reserve(arr, capacity);
+    return needed <= arr->allocated;
 }
 
+// Gives back the capacity past count. Allocators that can not shrink in
+// place move the items into a smaller block.
 template<typename T>
-T *array_add(Array<T> *arr) {
-    if (arr->count >= arr->allocated) {
-        s64 reserve_count = 2 * arr->allocated;
-        if (reserve_count < 8) reserve_count = 8;
+void array_shrink_to_fit(Array<T> *arr) {
+    if (arr->count == arr->allocated) return;
+
+    if (!arr->count) {
+        array_free(arr);
+        return;
+    }
 
-        array_reserve(arr, reserve_count);
+    if (!arr->allocator.proc) {
+        arr->allocator.proc = heap_allocator;
+        arr->allocator.data = null;
     }
 
+    if (!array_items_are_trivial<T>()) {
+        array_move_to_new_block(arr, arr->count);  // On failure the old block is still good.
+        return;
+    }
+
+    Allocator a = arr->allocator;
+
+    s64 size = size_of(T);
+    s64 num_bytes = arr->count * size;
+
+    void *new_memory = a.proc(ALLOCATOR_RESIZE, num_bytes, num_bytes, arr->data, a.data);
+    if (!new_memory) return;  // The old block is still good.
+
+    arr->data = (T *)new_memory;
+    arr->allocated = array_capacity_for_bytes(arr, allocator_usable_size(new_memory, num_bytes, a));
+}
+
+template<typename T>
+void array_add(Array<T> *arr, const T &item) {
+    s64 inside = array_index_of_pointer(arr, &item);
+    if (!array_grow(arr, 1)) return;
+
+    const T &value = (inside >= 0) ? arr->data[inside] : item;
+
+    new (arr->data + arr->count) T(value);
+    arr->count += 1;
+}
+
+// Moves item into the array, whatever it owns is not copied.
+template<typename T>
+void array_add(Array<T> *arr, T &&item) {
+    s64 inside = array_index_of_pointer(arr, &item);
+    if (!array_grow(arr, 1)) return;
+
+    T &value = (inside >= 0) ? arr->data[inside] : item;
+
+    new (arr->data + arr->count) T(std::move(value));
+    arr->count += 1;
+}
+
+template<typename T>
+T *array_add(Array<T> *arr) {
+    if (!array_grow(arr, 1)) return null;
+
     T *result = arr->data + arr->count;
     arr->count += 1;
 
+    // Reserved memory can be uninitialized, hand out a zeroed item.
+    if (array_items_are_trivial<T>()) {
+        memory_zero((void *)result, size_of(T));
+    } else {
+        new (result) T();
+    }
+
     return result;
 }
 
+
+// SIMD search.
+// Integers, enums and pointers of 1, 2, 4 or 8 bytes are compared by their bits,
+// ARRAY_SIMD_BYTES at a time. SSE2 by default, AVX2 when the compiler targets it.
+// Everything else, floats included (NaN, -0.0), goes through operator==.
+#if defined(__SSE2__) || (COMPILER_CL && (ARCH_X64 || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))))
+#define ARRAY_SIMD 1
+#else
+#define ARRAY_SIMD 0
+#endif
+
+#if ARRAY_SIMD
+#if !COMPILER_CL
+#include <immintrin.h>
+#endif
+
+#if defined(__AVX2__)
+typedef __m256i Array_Simd;
+const s64 ARRAY_SIMD_BYTES = 32;
+
+#define array_simd_load(p)       _mm256_loadu_si256((const __m256i *)(p))
+#define array_simd_store(p, v)   _mm256_storeu_si256((__m256i *)(p), (v))
+#define array_simd_or(a, b)      _mm256_or_si256((a), (b))
+#define array_simd_zero()        _mm256_setzero_si256()
+#define array_simd_byte_mask(v)  (u32)_mm256_movemask_epi8(v)
+
+inline Array_Simd array_simd_splat(u8 value)  { return _mm256_set1_epi8((char)value); }
+inline Array_Simd array_simd_splat(u16 value) { return _mm256_set1_epi16((short)value); }
+inline Array_Simd array_simd_splat(u32 value) { return _mm256_set1_epi32((int)value); }
+inline Array_Simd array_simd_splat(u64 value) { return _mm256_set1_epi64x((long long)value); }
+
+inline Array_Simd array_simd_equal(Array_Simd a, Array_Simd b, u8)  { return _mm256_cmpeq_epi8(a, b); }
+inline Array_Simd array_simd_equal(Array_Simd a, Array_Simd b, u16) { return _mm256_cmpeq_epi16(a, b); }
+inline Array_Simd array_simd_equal(Array_Simd a, Array_Simd b, u32) { return _mm256_cmpeq_epi32(a, b); }
+inline Array_Simd array_simd_equal(Array_Simd a, Array_Simd b, u64) { return _mm256_cmpeq_epi64(a, b); }
+
+inline Array_Simd array_simd_subtract(Array_Simd a, Array_Simd b, u8)  { return _mm256_sub_epi8(a, b); }
+inline Array_Simd array_simd_subtract(Array_Simd a, Array_Simd b, u16) { return _mm256_sub_epi16(a, b); }
+inline Array_Simd array_simd_subtract(Array_Simd a, Array_Simd b, u32) { return _mm256_sub_epi32(a, b); }
+inline Array_Simd array_simd_subtract(Array_Simd a, Array_Simd b, u64) { return _mm256_sub_epi64(a, b); }
+#else
+typedef __m128i Array_Simd;
+const s64 ARRAY_SIMD_BYTES = 16;
+
+#define array_simd_load(p)       _mm_loadu_si128((const __m128i *)(p))
+#define array_simd_store(p, v)   _mm_storeu_si128((__m128i *)(p), (v))
+#define array_simd_or(a, b)      _mm_or_si128((a), (b))
+#define array_simd_zero()        _mm_setzero_si128()
+#define array_simd_byte_mask(v)  (u32)_mm_movemask_epi8(v)
+
+inline Array_Simd array_simd_splat(u8 value)  { return _mm_set1_epi8((char)value); }
+inline Array_Simd array_simd_splat(u16 value) { return _mm_set1_epi16((short)value); }
+inline Array_Simd array_simd_splat(u32 value) { return _mm_set1_epi32((int)value); }
+inline Array_Simd array_simd_splat(u64 value) { return _mm_set1_epi64x((long long)value); }
+
+inline Array_Simd array_simd_equal(Array_Simd a, Array_Simd b, u8)  { return _mm_cmpeq_epi8(a, b); }
+inline Array_Simd array_simd_equal(Array_Simd a, Array_Simd b, u16) { return _mm_cmpeq_epi16(a, b); }
+inline Array_Simd array_simd_equal(Array_Simd a, Array_Simd b, u32) { return _mm_cmpeq_epi32(a, b); }
+
+// SSE2 has no 64 bit compare, both 32 bit halves have to match.
+inline Array_Simd array_simd_equal(Array_Simd a, Array_Simd b, u64) {
+    Array_Simd halves = _mm_cmpeq_epi32(a, b);
+    return _mm_and_si128(halves, _mm_shuffle_epi32(halves, _MM_SHUFFLE(2, 3, 0, 1)));
+}
+
+inline Array_Simd array_simd_subtract(Array_Simd a, Array_Simd b, u8)  { return _mm_sub_epi8(a, b); }
+inline Array_Simd array_simd_subtract(Array_Simd a, Array_Simd b, u16) { return _mm_sub_epi16(a, b); }
+inline Array_Simd array_simd_subtract(Array_Simd a, Array_Simd b, u32) { return _mm_sub_epi32(a, b); }
+inline Array_Simd array_simd_subtract(Array_Simd a, Array_Simd b, u64) { return _mm_sub_epi64(a, b); }
+#endif
+
+// All ones in the lanes of the block that hold the item.
+template<typename U>
+TINYRT_INLINE Array_Simd array_simd_equal_block(const U *block, Array_Simd value) {
+    return array_simd_equal(array_simd_load(block), value, U());
+}
+
+// One bit per byte of the block, set where the item matched.
+template<typename U>
+TINYRT_INLINE u32 array_simd_match(const U *block, Array_Simd value) {
+    return array_simd_byte_mask(array_simd_equal_block(block, value));
+}
+
+// Any match in four blocks, one branch for all of them.
+template<typename U>
+TINYRT_INLINE bool array_simd_match_any4(const U *blocks, s64 lanes, Array_Simd value) {
+    Array_Simd a = array_simd_or(array_simd_equal_block(blocks,             value), array_simd_equal_block(blocks + lanes,     value));
+    Array_Simd b = array_simd_or(array_simd_equal_block(blocks + 2 * lanes, value), array_simd_equal_block(blocks + 3 * lanes, value));
+    return array_simd_byte_mask(array_simd_or(a, b)) != 0;
+}
+
+inline s64 array_simd_first_bit(u32 mask) {
+#if COMPILER_CL
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (s64)index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+inline s64 array_simd_last_bit(u32 mask) {
+#if COMPILER_CL
+    unsigned long index;
+    _BitScanReverse(&index, mask);
+    return (s64)index;
+#else
+    return 31 - __builtin_clz(mask);
+#endif
+}
+#endif  // ARRAY_SIMD
+
+// The blocks are loaded through the words view, which the load intrinsics
+// may alias. The items left over are compared as T, never read through
+// the view, so the searches stay clear of strict aliasing.
+template<typename T, typename U>
+s64 array_simd_find(const T *data, s64 count, const T &item, U word) {
+    s64 index = 0;
+
+#if ARRAY_SIMD
+    const U *words = (const U *)data;
+    const s64 lanes = ARRAY_SIMD_BYTES / size_of(U);
+    Array_Simd value = array_simd_splat(word);
+
+    // Four blocks at a time until one of them matches, then find it block by block.
+    for (; index + 4 * lanes <= count; index += 4 * lanes) {
+        if (array_simd_match_any4(words + index, lanes, value)) break;
+    }
+
+    for (; index + lanes <= count; index += lanes) {
+        u32 mask = array_simd_match(words + index, value);
+        if (mask) return index + array_simd_first_bit(mask) / size_of(U);
+    }
+#else
+    UNUSED(word);
+#endif
+
+    for (; index < count; ++index) {
+        if (data[index] == item) return index;
+    }
+
+    return -1;
+}
+
+template<typename T, typename U>
+s64 array_simd_find_last(const T *data, s64 count, const T &item, U word) {
+    s64 index = count;
+
+#if ARRAY_SIMD
+    const U *words = (const U *)data;
+    const s64 lanes = ARRAY_SIMD_BYTES / size_of(U);
+    Array_Simd value = array_simd_splat(word);
+
+    for (; index >= 4 * lanes; index -= 4 * lanes) {
+        if (array_simd_match_any4(words + index - 4 * lanes, lanes, value)) break;
+    }
+
+    for (; index >= lanes; index -= lanes) {
+        u32 mask = array_simd_match(words + index - lanes, value);
+        if (mask) return index - lanes + array_simd_last_bit(mask) / size_of(U);
+    }
+#else
+    UNUSED(word);
+#endif
+
+    while (index > 0) {
+        index -= 1;
+        if (data[index] == item) return index;
+    }
+
+    return -1;
+}
+
+template<typename T, typename U>
+s64 array_simd_count(const T *data, s64 count, const T &item, U word) {
+    s64 result = 0;
+    s64 index  = 0;
+
+#if ARRAY_SIMD
+    const U *words = (const U *)data;
+    const s64 lanes = ARRAY_SIMD_BYTES / size_of(U);
+    Array_Simd value = array_simd_splat(word);
+
+    // Matching lanes are -1, subtracting them counts per lane. Narrow
+    // lanes would wrap, so their counts are summed up before that.
+    const s64 max_blocks = (size_of(U) == 1) ? 255 : 65535;
+
+    while (index + lanes <= count) {
+        s64 blocks = Min((count - index) / lanes, max_blocks);
+
+        Array_Simd counts = array_simd_zero();
+        for (s64 block = 0; block < blocks; ++block) {
+            counts = array_simd_subtract(counts, array_simd_equal_block(words + index, value), U());
+            index += lanes;
+        }
+
+        U lane_counts[ARRAY_SIMD_BYTES / size_of(U)];
+        array_simd_store(lane_counts, counts);
+
+        for (s64 lane = 0; lane < lanes; ++lane) result += (s64)lane_counts[lane];
+    }
+#else
+    UNUSED(word);
+#endif
+
+    for (; index < count; ++index) {
+        if (data[index] == item) result += 1;
+    }
+
+    return result;
+}
+
+template<typename T>
+constexpr bool array_simd_comparable(void) {
+    return (std::is_integral<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value) &&
+           ((size_of(T) == 1) || (size_of(T) == 2) || (size_of(T) == 4) || (size_of(T) == 8));
+}
+
+enum Array_Search {
+    ARRAY_SEARCH_FIRST,
+    ARRAY_SEARCH_LAST,
+    ARRAY_SEARCH_COUNT,
+};
+
+// word holds the bits of item.
+template<typename T, typename U>
+s64 array_simd_search(Array_Search search, const T *data, s64 count, const T &item, U word) {
+    switch (search) {
+        case ARRAY_SEARCH_FIRST: return array_simd_find(data, count, item, word);
+        case ARRAY_SEARCH_LAST:  return array_simd_find_last(data, count, item, word);
+        default:                 return array_simd_count(data, count, item, word);
+    }
+}
+
+// Shared by the Array and Small_Array searches.
 template<typename T>
-s64 array_find(Array<T> *array, T item) {
-    for (s64 index = 0; index < array->count; ++index) {
-        T it = array->data[index];
-        if (it == item) return index;
+s64 array_search_items(Array_Search search, T *items, s64 count, const T &item) {
+    if (array_simd_comparable<T>()) {
+        // Only the branch for the size of T runs, the others just have to compile.
+        switch (size_of(T)) {
+            case 1: { u8  word = 0; memcpy(&word, &item, size_of(T)); return array_simd_search(search, items, count, item, word); }
+            case 2: { u16 word = 0; memcpy(&word, &item, size_of(T)); return array_simd_search(search, items, count, item, word); }
+            case 4: { u32 word = 0; memcpy(&word, &item, size_of(T)); return array_simd_search(search, items, count, item, word); }
+            case 8: { u64 word = 0; memcpy(&word, &item, size_of(T)); return array_simd_search(search, items, count, item, word); }
+        }
+    }
+
+    if (search == ARRAY_SEARCH_LAST) {
+        for (s64 index = count - 1; index >= 0; --index) {
+            if (items[index] == item) return index;
+        }
+
+        return -1;
+    }
+
+    s64 matches = 0;
+    for (s64 index = 0; index < count; ++index) {
+        if (!(items[index] == item)) continue;
+
+        if (search == ARRAY_SEARCH_FIRST) return index;
+        matches += 1;
     }
 
-    return -1;  // Not found.
+    return (search == ARRAY_SEARCH_FIRST) ? -1 : matches;
+}
+
+template<typename T>
+s64 array_find(Array<T> *array, const T &item) {
+    return array_search_items(ARRAY_SEARCH_FIRST, array->data, array->count, item);  // -1 if not found.
+}
+
+template<typename T>
+s64 array_find_last(Array<T> *array, const T &item) {
+    return array_search_items(ARRAY_SEARCH_LAST, array->data, array->count, item);
+}
+
+template<typename T>
+s64 array_count_matching(Array<T> *array, const T &item) {
+    return array_search_items(ARRAY_SEARCH_COUNT, array->data, array->count, item);
+}
+
+template<typename T>
+bool array_contains(Array<T> *array, const T &item) {
+    return array_find(array, item) >= 0;
 }
 
 template<typename T>
@@ -157,6 +736,13 @@ void array_resize(Array<T> *array, s64 size) {
             array->allocator.data = null;
         }
 
+        if (!array_items_are_trivial<T>()) {
+            bool moved = array_move_to_new_block(array, size);
+            assert(moved);
+            UNUSED(moved);
+            return;
+        }
+
         Allocator a = array->allocator;
 
         s64 stride = size_of(T);
@@ -180,7 +766,408 @@ bool array_pop(Array<T> *array, T *value_return) {
         return false;
     }
 
-    *value_return = array->data[array->count-1];
+    *value_return = std::move(array->data[array->count-1]);
+    array_destroy_items(array->data + array->count - 1, 1);
     array->count -= 1;
     return true;
 }
+
+// One reserve and one copy for the whole batch, items may come from arr itself.
+template<typename T>
+void array_add_many(Array<T> *arr, T *items, s64 count) {
+    assert(count >= 0);
+    if (!count) return;
+
+    // Items can come from the array itself, growing moves them.
+    s64 inside = array_index_of_pointer(arr, items);
+    assert((inside < 0) ? ((items + count <= arr->data) || (items >= arr->data + arr->allocated)) : (inside + count <= arr->count));
+
+    if (!array_grow(arr, count)) return;
+    if (inside >= 0) items = arr->data + inside;
+
+    if (array_items_are_trivial<T>()) {
+        memcpy((void *)(arr->data + arr->count), items, (umm)(count * size_of(T)));
+    } else {
+        for (s64 index = 0; index < count; ++index) new (arr->data + arr->count + index) T(items[index]);
+    }
+
+    arr->count += count;
+}
+
+template<typename T>
+void array_add_many(Array<T> *arr, Array<T> *items) {
+    array_add_many(arr, items->data, items->count);
+}
+
+// False if the item was there already.
+template<typename T>
+bool array_add_if_unique(Array<T> *arr, const T &item) {
+    if (array_find(arr, item) >= 0) return false;
+
+    array_add(arr, item);
+    return true;
+}
+
+// Items from index on move up by one.
+template<typename T>
+void array_insert_at(Array<T> *arr, T item, s64 index) {
+    assert(index >= 0);
+    assert(index <= arr->count);
+    if (!array_grow(arr, 1)) return;
+
+    T *data = arr->data;
+
+    if (array_items_are_trivial<T>()) {
+        memmove((void *)(data + index + 1), data + index, (umm)((arr->count - index) * size_of(T)));
+        data[index] = item;
+    } else if (index == arr->count) {
+        new (data + index) T(std::move(item));
+    } else {
+        new (data + arr->count) T(std::move(data[arr->count - 1]));
+        for (s64 move = arr->count - 1; move > index; --move) data[move] = std::move(data[move - 1]);
+        data[index] = std::move(item);
+    }
+
+    arr->count += 1;
+}
+
+// Keeps the order, items past index move down by one.
+template<typename T>
+void array_ordered_remove_by_index(Array<T> *arr, s64 index) {
+    assert(index >= 0);
+    assert(index < arr->count);
+
+    if (array_items_are_trivial<T>()) {
+        memmove((void *)(arr->data + index), arr->data + index + 1, (umm)((arr->count - index - 1) * size_of(T)));
+    } else {
+        for (s64 move = index; move < arr->count - 1; ++move) arr->data[move] = std::move(arr->data[move + 1]);
+        array_destroy_items(arr->data + arr->count - 1, 1);
+    }
+
+    arr->count -= 1;
+}
+
+// The last item takes the place of the removed one.
+template<typename T>
+void array_unordered_remove_by_index(Array<T> *arr, s64 index) {
+    assert(index >= 0);
+    assert(index < arr->count);
+
+    if (index != arr->count - 1) arr->data[index] = std::move(arr->data[arr->count - 1]);
+    array_destroy_items(arr->data + arr->count - 1, 1);
+    arr->count -= 1;
+}
+
+// Removes every copy of item in one pass, returns how many went.
+template<typename T>
+s64 array_ordered_remove(Array<T> *arr, T item) {
+    s64 kept = 0;
+
+    for (s64 index = 0; index < arr->count; ++index) {
+        if (arr->data[index] == item) continue;
+
+        if (kept != index) arr->data[kept] = std::move(arr->data[index]);
+        kept += 1;
+    }
+
+    array_destroy_items(arr->data + kept, arr->count - kept);
+
+    s64 removed = arr->count - kept;
+    arr->count = kept;
+    return removed;
+}
+
+template<typename T>
+s64 array_unordered_remove(Array<T> *arr, T item) {
+    s64 removed = 0;
+
+    for (s64 index = 0; index < arr->count; ) {
+        if (arr->data[index] == item) {
+            array_unordered_remove_by_index(arr, index);
+            removed += 1;
+        } else {
+            index += 1;
+        }
+    }
+
+    return removed;
+}
+
+
+// Keeps the first N items inline, the allocator only sees arrays that grow
+// past that. data stays null while the items are inline, so a copy of the
+// struct does not point into the storage of the original.
+template<typename T, s64 N>
+struct Small_Array {
+    static_assert(N > 0, "Small_Array needs room for at least one item.");
+    static_assert(std::is_trivially_copyable<T>::value, "Small_Array moves its items as bytes, use Array for items with constructors.");
+
+    s64 allocated = N;
+    s64 count     = 0;
+    T *data       = null;
+
+    Allocator allocator = {heap_allocator, null};
+
+    T storage[N];
+
+    TINYRT_INLINE T &operator[] (s64 index) {
+        assert(index >= 0);
+        assert(index < this->count);
+        return (this->data ? this->data : this->storage)[index];
+    }
+
+    TINYRT_INLINE T *begin() { return this->data ? this->data : this->storage; }
+    TINYRT_INLINE T *end()   { return this->begin() + this->count; }
+};
+
+template<typename T, s64 N>
+TINYRT_INLINE T *small_array_items(Small_Array<T, N> *arr) {
+    return arr->data ? arr->data : arr->storage;
+}
+
+template<typename T, s64 N>
+void array_free(Small_Array<T, N> *arr) {
+    if (arr->data) {
+        Allocator a = arr->allocator;
+
+        if (!a.proc) {
+            a.proc = heap_allocator;
+            a.data = null;
+        }
+
+        a.proc(ALLOCATOR_FREE, 0, 0, arr->data, a.data);
+        arr->data = null;
+    }
+
+    arr->count     = 0;
+    arr->allocated = N;
+}
+
+template<typename T, s64 N>
+TINYRT_INLINE void array_reset(Small_Array<T, N> *arr) {
+    arr->count = 0;
+}
+
+template<typename T, s64 N>
+void array_reserve(Small_Array<T, N> *arr, s64 reserve) {
+    if (reserve <= arr->allocated) return;
+
+    s64 size = size_of(T);
+    s64 num_bytes = reserve * size;
+
+    if (!arr->allocator.proc) {
+        arr->allocator.proc = heap_allocator;
+        arr->allocator.data = null;
+    }
+
+    Allocator a = arr->allocator;
+
+    void *new_memory;
+    if (arr->data) {
+        new_memory = a.proc(ALLOCATOR_RESIZE, num_bytes, arr->count * size, arr->data, a.data);
+    } else {
+        // Spilling out of the inline storage.
+        new_memory = allocator_call(a, ALLOCATOR_ALLOCATE_UNINITIALIZED, num_bytes);
+        if (new_memory) memcpy(new_memory, arr->storage, (umm)(arr->count * size));
+    }
+    assert(new_memory != null);
+
+    if (!new_memory) return;
+
+    arr->data = (T *)new_memory;
+    arr->allocated = allocator_usable_size(new_memory, num_bytes, a) / size;
+}
+
+template<typename T, s64 N>
+void array_add(Small_Array<T, N> *arr, T item) {
+    if (arr->count >= arr->allocated) {
+        array_reserve(arr, 2 * arr->allocated);
+        if (arr->count >= arr->allocated) return;
+    }
+
+    small_array_items(arr)[arr->count] = item;
+    arr->count += 1;
+}
+
+template<typename T, s64 N>
+T *array_add(Small_Array<T, N> *arr) {
+    if (arr->count >= arr->allocated) {
+        array_reserve(arr, 2 * arr->allocated);
+        if (arr->count >= arr->allocated) return null;
+    }
+
+    T *result = small_array_items(arr) + arr->count;
+    arr->count += 1;
+
+    memory_zero(result, size_of(T));
+
+    return result;
+}
+
+template<typename T, s64 N>
+s64 array_find(Small_Array<T, N> *array, T item) {
+    return array_search_items(ARRAY_SEARCH_FIRST, small_array_items(array), array->count, item);
+}
+
+template<typename T, s64 N>
+bool array_contains(Small_Array<T, N> *array, T item) {
+    return array_find(array, item) >= 0;
+}
+
+template<typename T, s64 N>
+bool array_pop(Small_Array<T, N> *array, T *value_return) {
+    if (array->count == 0) {
+        write_string("Panic: Attempt to pop an empty array.\n", /*bool to_standard_error=*/true);
+        assert(0);
+        return false;
+    }
+
+    *value_return = small_array_items(array)[array->count-1];
+    array->count -= 1;
+    return true;
+}
+
+
+// Array_View algorithms.
+// Slices and chunks are views into the same items, nothing is allocated.
+
+template<typename T, s64 N>
+TINYRT_INLINE Array_View<T> array_view(Small_Array<T, N> *array) {
+    return array_view(small_array_items(array), array->count);
+}
+
+// count items from start on, -1 for everything past start.
+template<typename T>
+Array_View<T> array_slice(Array_View<T> view, s64 start, s64 count = -1) {
+    if (count < 0) count = view.count - start;
+
+    assert(start >= 0);
+    assert(count >= 0);
+    assert(start + count <= view.count);
+
+    return array_view(view.data + start, count);
+}
+
+template<typename T>
+TINYRT_INLINE Array_View<T> array_slice(Array<T> *array, s64 start, s64 count = -1) {
+    return array_slice(array_view(array), start, count);
+}
+
+// Part chunk_index of chunk_count about equal parts, for splitting work between threads.
+template<typename T>
+Array_View<T> array_chunk(Array_View<T> view, s64 chunk_index, s64 chunk_count) {
+    assert(chunk_count > 0);
+    assert((chunk_index >= 0) && (chunk_index < chunk_count));
+
+    s64 start = view.count * chunk_index / chunk_count;
+    s64 end   = view.count * (chunk_index + 1) / chunk_count;
+    return array_view(view.data + start, end - start);
+}
+
+template<typename T>
+s64 array_find(Array_View<T> view, const T &item) {
+    return array_search_items(ARRAY_SEARCH_FIRST, view.data, view.count, item);  // -1 if not found.
+}
+
+template<typename T>
+s64 array_find_last(Array_View<T> view, const T &item) {
+    return array_search_items(ARRAY_SEARCH_LAST, view.data, view.count, item);
+}
+
+template<typename T>
+s64 array_count_matching(Array_View<T> view, const T &item) {
+    return array_search_items(ARRAY_SEARCH_COUNT, view.data, view.count, item);
+}
+
+template<typename T>
+bool array_contains(Array_View<T> view, const T &item) {
+    return array_find(view, item) >= 0;
+}
+
+const s64 ARRAY_SORT_INSERTION_COUNT = 16;  // Shorter runs are insertion sorted.
+
+// Sorts in place with less(a, b) as the order, not stable. Quick sort with a
+// median of three pivot, recursing into the smaller part only, so the stack
+// stays at log n. less inlines, unlike the compare of quick_sort.
+template<typename T, typename Less>
+void array_sort(Array_View<T> view, Less less) {
+    T *data   = view.data;
+    s64 count = view.count;
+
+    while (count > ARRAY_SORT_INSERTION_COUNT) {
+        s64 middle = count / 2;
+
+        // Also puts the smallest and biggest of the three at the ends, they
+        // stop the partition scans without bounds checks.
+        if (less(data[middle], data[0]))         std::swap(data[middle], data[0]);
+        if (less(data[count - 1], data[0]))      std::swap(data[count - 1], data[0]);
+        if (less(data[count - 1], data[middle])) std::swap(data[count - 1], data[middle]);
+
+        T pivot = data[middle];
+
+        s64 i = 0;
+        s64 j = count - 1;
+        while (true) {
+            while (less(data[i], pivot)) i += 1;
+            while (less(pivot, data[j])) j -= 1;
+            if (i >= j) break;
+
+            std::swap(data[i], data[j]);
+            i += 1;
+            j -= 1;
+        }
+
+        s64 left = j + 1;
+        if (left < count - left) {
+            array_sort(array_view(data, left), less);
+            data  += left;
+            count -= left;
+        } else {
+            array_sort(array_view(data + left, count - left), less);
+            count = left;
+        }
+    }
+
+    for (s64 index = 1; index < count; ++index) {
+        T value = std::move(data[index]);
+
+        s64 slot = index;
+        for (; (slot > 0) && less(value, data[slot - 1]); --slot) data[slot] = std::move(data[slot - 1]);
+
+        data[slot] = std::move(value);
+    }
+}
+
+template<typename T>
+void array_sort(Array_View<T> view) {
+    array_sort(view, [](const T &a, const T &b) { return a < b; });
+}
+
+// First index whose item is not less than item, view.count if there is none.
+// The view has to be sorted.
+template<typename T>
+s64 array_lower_bound(Array_View<T> view, const T &item) {
+    s64 low  = 0;
+    s64 high = view.count;
+
+    while (low < high) {
+        s64 middle = low + (high - low) / 2;
+
+        if (view.data[middle] < item) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+// Index of an item equal to item in a sorted view, -1 if there is none.
+template<typename T>
+s64 array_binary_search(Array_View<T> view, const T &item) {
+    s64 index = array_lower_bound(view, item);
+    if ((index < view.count) && !(item < view.data[index])) return index;
+
+    return -1;
+}
@@ -0,0 +1,78 @@
+/*
+
+    array_find, array_find_last and array_count_matching against a plain
+    element by element loop, for u8, u32, u64 and pointer arrays of
+    growing size. The items searched for sit at the far end, so every
+    search scans the whole array.
+
+    g++ -O2 -o array_find array_find.cpp           SSE2
+    g++ -O2 -mavx2 -o array_find array_find.cpp    AVX2
+
+*/
+
+#include "benchmark.h"
+#include "../array.h"
+
+const s64 SCANNED_PER_SIZE = 1ll << 30;  // Items scanned for every size and type.
+
+static s64 sink = 0;
+
+template<typename T>
+__attribute__((noinline)) s64 scalar_find(Array<T> *array, T item) {
+    for (s64 index = 0; index < array->count; ++index) {
+        T it = array->data[index];
+        if (it == item) return index;
+    }
+
+    return -1;
+}
+
+template<typename T>
+static void run(const char *name, s64 count) {
+    Array<T> array = {};
+    for (s64 index = 0; index < count; ++index) array_add(&array, (T)(index % 100));
+
+    T item  = (T)101;
+    T first = (T)102;
+    array.data[count - 1] = item;
+    array.data[0]         = first;
+
+    s64 rounds = Max(SCANNED_PER_SIZE / count, (s64)1);
+    float64 ns[4];
+
+    for (s64 kind = 0; kind < 4; ++kind) {
+        u64 start = benchmark_now_nanoseconds();
+
+        for (s64 round = 0; round < rounds; ++round) {
+            // Keeps the compiler from hoisting the search out of the loop.
+            __asm__ volatile("" : : "r"(array.data) : "memory");
+
+            if (kind == 0) sink += scalar_find(&array, item);
+            if (kind == 1) sink += array_find(&array, item);
+            if (kind == 2) sink += array_find_last(&array, first);
+            if (kind == 3) sink += array_count_matching(&array, item);
+        }
+
+        ns[kind] = (float64)(benchmark_now_nanoseconds() - start) / (float64)rounds;
+    }
+
+    print("%6s %9lld %12.1f %12.1f %9.1fx %12.1f %12.1f\n", name, count, ns[0], ns[1], ns[0] / ns[1], ns[2], ns[3]);
+    array_free(&array);
+}
+
+int main(void) {
+#if ARRAY_SIMD
+    print("%lld byte vectors\n", (long long)ARRAY_SIMD_BYTES);
+#endif
+    print("%6s %9s %12s %12s %10s %12s %12s\n", "type", "count", "scalar ns", "find ns", "speedup", "last ns", "count ns");
+
+    for (s64 count = 16; count <= (1 << 20); count *= 8) {
+        run<u8>("u8", count);
+        run<u32>("u32", count);
+        run<u64>("u64", count);
+        run<u8 *>("ptr", count);
+    }
+
+    print("(%lld)\n", sink);
+    return 0;
+}
@@ -0,0 +1,69 @@
+/*
+
+    Grows big Array<T>s one element at a time with the 2x and 1.5x
+    growth policies and reports the time, how many resizes moved the
+    block, and the unused capacity left at the end, before and after
+    array_shrink_to_fit.
+
+    g++ -O2 -o array_growth array_growth.cpp
+
+*/
+
+#include "benchmark.h"
+#include "../array.h"
+
+static s64 resizes = 0;
+static s64 moves   = 0;
+
+static ALLOCATOR_PROC(counting_allocator) {
+    UNUSED(allocator_data);
+
+    void *result = heap_allocator(mode, size, old_size, old_memory, null);
+
+    if ((mode == ALLOCATOR_RESIZE) && old_memory) {
+        resizes += 1;
+        if (result != old_memory) moves += 1;
+    }
+
+    return result;
+}
+
+static void grow_array(s64 count, const char *name, const Array_Growth *growth) {
+    resizes = 0;
+    moves   = 0;
+
+    Array<u64> array = {};
+    array.allocator = {counting_allocator, null};
+    array.growth    = growth;
+
+    u64 start = benchmark_now_nanoseconds();
+
+    for (s64 index = 0; index < count; ++index) {
+        array_add(&array, (u64)index);
+    }
+
+    float64 seconds = benchmark_seconds_since(start);
+
+    if (array.data[count-1] != (u64)(count-1)) write_string("Mismatch!\n", true);
+
+    float64 waste = (float64)(array.allocated - array.count) * 100.0 / (float64)array.allocated;
+
+    array_shrink_to_fit(&array);
+    float64 shrunk_waste = (float64)(array.allocated - array.count) * 100.0 / (float64)array.allocated;
+
+    print("%12lld %6s %10.2f %9lld %7lld %9.1f%% %9.3f%%\n",
+          count, name, seconds * 1000.0, resizes, moves, waste, shrunk_waste);
+
+    array_free(&array);
+}
+
+int main(void) {
+    print("%12s %6s %10s %9s %7s %10s %10s\n", "elements", "growth", "ms", "resizes", "moves", "unused", "shrunk");
+
+    for (s64 count = 1000000; count <= 64000000; count *= 4) {
+        grow_array(count, "2x", &ARRAY_GROWTH_DEFAULT);
+        grow_array(count, "1.5x", &ARRAY_GROWTH_HALF);
+    }
+
+    return 0;
+}
@@ -0,0 +1,88 @@
+/*
+
+    Fills Array<T>s of items that own a heap buffer, adding them by copy
+    and by move, and counts the deep copies the array makes on its own
+    while it grows. Items that are not trivially copyable are moved into
+    the new block, so that column should stay at zero.
+
+    g++ -O2 -o array_move array_move.cpp
+
+*/
+
+#include "benchmark.h"
+#include "../array.h"
+
+const s64 PAYLOAD_BYTES = 256;
+
+static s64 deep_copies = 0;
+
+struct Payload {
+    u8 *bytes = null;
+
+    Payload() {}
+
+    explicit Payload(u8 fill) {
+        bytes = (u8 *)heap_alloc_uninitialized(PAYLOAD_BYTES);
+        memset(bytes, fill, PAYLOAD_BYTES);
+    }
+
+    Payload(const Payload &other) {
+        deep_copies += 1;
+        if (!other.bytes) return;
+
+        bytes = (u8 *)heap_alloc_uninitialized(PAYLOAD_BYTES);
+        memcpy(bytes, other.bytes, PAYLOAD_BYTES);
+    }
+
+    Payload(Payload &&other) : bytes(other.bytes) { other.bytes = null; }
+
+    Payload &operator=(Payload other) {
+        u8 *swap = bytes;
+        bytes = other.bytes;
+        other.bytes = swap;
+        return *this;
+    }
+
+    ~Payload() { if (bytes) heap_free(bytes); }
+};
+
+static void fill(s64 count, bool by_move) {
+    deep_copies = 0;
+
+    Array<Payload> array = {};
+
+    u64 start = benchmark_now_nanoseconds();
+
+    for (s64 index = 0; index < count; ++index) {
+        Payload item((u8)index);
+
+        if (by_move) {
+            array_add(&array, std::move(item));
+        } else {
+            array_add(&array, item);
+        }
+    }
+
+    float64 seconds = benchmark_seconds_since(start);
+
+    // Copies made by adding by copy are expected, the rest come from growing.
+    s64 growth_copies = deep_copies - (by_move ? 0 : count);
+
+    if (array.data[count-1].bytes[0] != (u8)(count-1)) write_string("Mismatch!\n", true);
+
+    print("%10lld %6s %10.2f %12.1f %14lld\n", count, by_move ? "move" : "copy",
+          seconds * 1000.0, seconds * 1e9 / (float64)count, growth_copies);
+
+    array_free(&array);
+}
+
+int main(void) {
+    print("%10s %6s %10s %12s %14s\n", "items", "add", "ms", "ns per item", "growth copies");
+
+    for (s64 count = 10000; count <= 1000000; count *= 10) {
+        fill(count, false);
+        fill(count, true);
+    }
+
+    return 0;
+}
@@ -0,0 +1,105 @@
+/*
+
+    Works on parts of a big Array<u32> the way we had to before views, by
+    copying each part into an array of its own, and through Array_View
+    slices that point into the original. Also sorts with array_sort
+    against quick_sort, whose compare goes through a function pointer.
+
+    g++ -O2 -o array_view array_view.cpp
+
+*/
+
+#include "benchmark.h"
+#include "../array.h"
+
+const s64 ITEM_COUNT  = 1 << 22;
+const s64 CHUNK_COUNT = 64;
+const s64 ROUNDS      = 20;
+
+static s64 sink = 0;
+
+static s64 compare_u32(void *a, void *b) {
+    u32 x = *(u32 *)a;
+    u32 y = *(u32 *)b;
+    return (x > y) - (x < y);
+}
+
+static void fill(Array<u32> *array, u32 seed) {
+    array_reset(array);
+    for (s64 index = 0; index < ITEM_COUNT; ++index) {
+        seed = seed * 1664525u + 1013904223u;
+        array_add(array, seed >> 8);
+    }
+}
+
+int main(void) {
+    Array<u32> items = {};
+    fill(&items, 1);
+
+    // Counting matches chunk by chunk, like a worker per chunk would.
+    Array<u32> part = {};
+
+    u64 start = benchmark_now_nanoseconds();
+    for (s64 round = 0; round < ROUNDS; ++round) {
+        for (s64 chunk = 0; chunk < CHUNK_COUNT; ++chunk) {
+            s64 first = ITEM_COUNT * chunk / CHUNK_COUNT;
+            s64 last  = ITEM_COUNT * (chunk + 1) / CHUNK_COUNT;
+
+            array_reset(&part);
+            array_add_many(&part, items.data + first, last - first);
+            sink += array_count_matching(&part, (u32)round);
+        }
+    }
+    float64 copy_ms = benchmark_seconds_since(start) * 1000.0 / ROUNDS;
+
+    start = benchmark_now_nanoseconds();
+    for (s64 round = 0; round < ROUNDS; ++round) {
+        for (s64 chunk = 0; chunk < CHUNK_COUNT; ++chunk) {
+            sink += array_count_matching(array_chunk(array_view(&items), chunk, CHUNK_COUNT), (u32)round);
+        }
+    }
+    float64 view_ms = benchmark_seconds_since(start) * 1000.0 / ROUNDS;
+
+    print("%lld items in %lld chunks\n", ITEM_COUNT, CHUNK_COUNT);
+    print("%-28s %10.3f ms\n", "count per chunk, copied", copy_ms);
+    print("%-28s %10.3f ms  %.1fx\n", "count per chunk, view", view_ms, copy_ms / view_ms);
+
+    // Sorting.
+    fill(&items, 2);
+    start = benchmark_now_nanoseconds();
+    quick_sort(items.data, items.count, size_of(u32), compare_u32);
+    float64 quick_sort_ms = benchmark_seconds_since(start) * 1000.0;
+
+    fill(&items, 2);
+    start = benchmark_now_nanoseconds();
+    array_sort(array_view(&items));
+    float64 array_sort_ms = benchmark_seconds_since(start) * 1000.0;
+
+    for (s64 index = 1; index < items.count; ++index) {
+        if (items.data[index - 1] > items.data[index]) write_string("Not sorted!\n", true);
+    }
+
+    // Sorting every chunk on its own, in place.
+    fill(&items, 3);
+    start = benchmark_now_nanoseconds();
+    for (s64 chunk = 0; chunk < CHUNK_COUNT; ++chunk) array_sort(array_chunk(array_view(&items), chunk, CHUNK_COUNT));
+    float64 chunks_ms = benchmark_seconds_since(start) * 1000.0;
+
+    start = benchmark_now_nanoseconds();
+    for (s64 round = 0; round < ROUNDS; ++round) {
+        for (s64 index = 0; index < 1000000; ++index) {
+            sink += array_binary_search(array_chunk(array_view(&items), 0, CHUNK_COUNT), (u32)index << 8);
+        }
+    }
+    float64 search_ns = benchmark_seconds_since(start) * 1e9 / (ROUNDS * 1000000.0);
+
+    print("%-28s %10.3f ms\n", "quick_sort", quick_sort_ms);
+    print("%-28s %10.3f ms  %.1fx\n", "array_sort", array_sort_ms, quick_sort_ms / array_sort_ms);
+    print("%-28s %10.3f ms\n", "array_sort per chunk", chunks_ms);
+    print("%-28s %10.1f ns\n", "array_binary_search", search_ns);
+    print("(%lld)\n", sink);
+
+    array_free(&part);
+    array_free(&items);
+    return 0;
+}
@@ -0,0 +1,28 @@
+#ifndef GENERAL_BENCHMARK_INCLUDE_H
+#define GENERAL_BENCHMARK_INCLUDE_H
+/*
+
+    Shared helpers for the benchmarks in this folder.
+
+    Every benchmark is a single translation unit, build it with:
+        g++ -O2 -o <name> <name>.cpp
+
+*/
+
+#define GENERAL_DEBUG 0
+#define GENERAL_IMPLEMENTATION
+#include "../general.h"
+
+#include <time.h>
+
+inline u64 benchmark_now_nanoseconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000000ull + (u64)ts.tv_nsec;
+}
+
+inline float64 benchmark_seconds_since(u64 start) {
+    return (float64)(benchmark_now_nanoseconds() - start) / 1e9;
+}
+
+#endif  // GENERAL_BENCHMARK_INCLUDE_H
@@ -0,0 +1,117 @@
+/*
+
+    Keeps a set of pointer stable objects the way we used to, one heap
+    allocation per object with the pointers in an Array, against
+    Bucket_Array with buckets from the heap and from a Pool. Times adding
+    them, churn, removing every other object and adding it back, and
+    iterating them after the churn.
+
+    g++ -O2 -o bucket_array bucket_array.cpp
+
+*/
+
+#include "benchmark.h"
+
+#define POOL_IMPLEMENTATION
+#include "../pool.h"
+#include "../bucket_array.h"
+
+const s64 OBJECT_COUNT = 1000000;
+const s64 ROUNDS       = 10;
+
+struct Particle {
+    float64 position[3];
+    float64 velocity[3];
+    u64 id;
+};
+
+static u64 checksum = 0;
+
+static void report(const char *name, float64 add_ms, float64 churn_ms, float64 iterate_ms) {
+    print("%-24s %10.2f %10.2f %12.2f\n", name, add_ms, churn_ms, iterate_ms);
+}
+
+static void run_individual(void) {
+    Array<Particle *> particles = {};
+
+    u64 start = benchmark_now_nanoseconds();
+    for (s64 index = 0; index < OBJECT_COUNT; ++index) {
+        Particle *p = New(Particle);
+        p->id = (u64)index;
+        array_add(&particles, p);
+    }
+    float64 add_ms = benchmark_seconds_since(start) * 1000.0;
+
+    start = benchmark_now_nanoseconds();
+    for (s64 index = 0; index < particles.count; index += 2) {
+        heap_free(particles.data[index]);
+        particles.data[index] = New(Particle);
+        particles.data[index]->id = (u64)index;
+    }
+    float64 churn_ms = benchmark_seconds_since(start) * 1000.0;
+
+    start = benchmark_now_nanoseconds();
+    for (s64 round = 0; round < ROUNDS; ++round) {
+        For(particles) checksum += it->id;
+    }
+    float64 iterate_ms = benchmark_seconds_since(start) * 1000.0 / ROUNDS;
+
+    For(particles) heap_free(it);
+    array_free(&particles);
+
+    report("heap object + Array", add_ms, churn_ms, iterate_ms);
+}
+
+static void run_buckets(const char *name, Allocator allocator) {
+    Bucket_Array<Particle> particles;
+    particles.allocator = allocator;
+
+    Array<Bucket_Locator> locators = {};
+    array_reserve(&locators, OBJECT_COUNT);
+
+    u64 start = benchmark_now_nanoseconds();
+    for (s64 index = 0; index < OBJECT_COUNT; ++index) {
+        Bucket_Locator locator;
+        Particle *p = bucket_array_add(&particles, &locator);
+        p->id = (u64)index;
+        locators.data[index] = locator;
+    }
+    locators.count = OBJECT_COUNT;
+    float64 add_ms = benchmark_seconds_since(start) * 1000.0;
+
+    start = benchmark_now_nanoseconds();
+    for (s64 index = 0; index < locators.count; index += 2) {
+        bucket_array_remove(&particles, locators.data[index]);
+
+        Particle *p = bucket_array_add(&particles, &locators.data[index]);
+        p->id = (u64)index;
+    }
+    float64 churn_ms = benchmark_seconds_since(start) * 1000.0;
+
+    start = benchmark_now_nanoseconds();
+    for (s64 round = 0; round < ROUNDS; ++round) {
+        For(particles) checksum += it.id;
+    }
+    float64 iterate_ms = benchmark_seconds_since(start) * 1000.0 / ROUNDS;
+
+    bucket_array_free(&particles);
+    array_free(&locators);
+
+    report(name, add_ms, churn_ms, iterate_ms);
+}
+
+int main(void) {
+    print("%lld objects of %lld bytes\n", OBJECT_COUNT, (s64)size_of(Particle));
+    print("%-24s %10s %10s %12s\n", "", "add ms", "churn ms", "iterate ms");
+
+    run_individual();
+    run_buckets("Bucket_Array, heap", {heap_allocator, null});
+
+    Pool pool;
+    pool_init(&pool, MB(1));
+    run_buckets("Bucket_Array, Pool", {pool_allocator_proc, &pool});
+    pool_release(&pool);
+
+    print("(%llu)\n", (unsigned long long)checksum);
+    return 0;
+}
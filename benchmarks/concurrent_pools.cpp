@@ -0,0 +1,238 @@
+/*
+
+    Small blocks from many threads at once.
+
+    The bump phase allocates without freeing, from heap_allocator, from
+    one Concurrent_Pool shared by every thread, and from the per-node
+    pools of a Numa_Pool_Registry. Every block gets stamped with its
+    thread, and the stamps are checked after the threads join. Machines
+    with a single node, and containers that refuse mbind, run the
+    registry on its fallback path. The bound and unbound block counts
+    show which path ran.
+
+    The churn phase frees and allocates through heap_allocator, directly
+    and wrapped in allocation_stats_proc, to show what the counters cost.
+    The stats dump closes the run.
+
+    g++ -O2 -pthread -o concurrent_pools concurrent_pools.cpp
+
+*/
+
+#include "benchmark.h"
+
+#define POOL_IMPLEMENTATION
+#include "../pool.h"
+
+#define NUMA_IMPLEMENTATION
+#include "../numa.h"
+
+#define ALLOCATION_STATS_IMPLEMENTATION
+#include "../allocation_stats.h"
+
+#include <pthread.h>
+
+const s64 MAX_THREADS           = 16;
+const s64 BLOCKS_PER_THREAD     = 256 * 1024;
+const s64 OPERATIONS_PER_THREAD = 2000000;
+const s64 LIVE_BLOCKS           = 256;
+
+enum Bump_Source {
+    BUMP_HEAP,
+    BUMP_CONCURRENT_POOL,
+    BUMP_NUMA_REGISTRY,
+};
+
+struct Worker {
+    Bump_Source source;
+    Allocator allocator;
+    Concurrent_Pool *pool;
+    Numa_Pool_Registry *registry;
+
+    u8 stamp;
+    u8 **blocks;
+    s64 *sizes;
+    u32 seed;
+};
+
+static void *bump_proc(void *data) {
+    Worker *worker = (Worker *)data;
+
+    Concurrent_Pool *pool = worker->pool;
+    if (worker->source == BUMP_NUMA_REGISTRY) pool = numa_pool_for_current_node(worker->registry);
+
+    u32 seed = worker->seed;
+    for (s64 index = 0; index < BLOCKS_PER_THREAD; ++index) {
+        seed = seed * 1664525u + 1013904223u;
+        s64 size = 16 + (s64)((seed >> 16) % 113);
+
+        u8 *block;
+        if (worker->source == BUMP_HEAP) {
+            block = (u8 *)heap_alloc_uninitialized(size);
+        } else {
+            block = (u8 *)concurrent_pool_get(pool, size);
+        }
+
+        memset(block, worker->stamp, (size_t)size);
+        worker->blocks[index] = block;
+        worker->sizes[index]  = size;
+    }
+
+    return null;
+}
+
+static void *churn_proc(void *data) {
+    Worker *worker = (Worker *)data;
+    Allocator a = worker->allocator;
+
+    void *blocks[LIVE_BLOCKS] = {};
+    u32 seed = worker->seed;
+
+    for (s64 index = 0; index < OPERATIONS_PER_THREAD; ++index) {
+        seed = seed * 1664525u + 1013904223u;
+
+        s64 slot = (s64)((seed >> 8) % LIVE_BLOCKS);
+        s64 size = 16 + (s64)((seed >> 16) % 512);
+
+        if (blocks[slot]) a.proc(ALLOCATOR_FREE, 0, 0, blocks[slot], a.data);
+        blocks[slot] = a.proc(ALLOCATOR_ALLOCATE, size, 0, null, a.data);
+    }
+
+    for (s64 index = 0; index < LIVE_BLOCKS; ++index) {
+        if (blocks[index]) a.proc(ALLOCATOR_FREE, 0, 0, blocks[index], a.data);
+    }
+
+    return null;
+}
+
+static float64 run(Worker *workers, s64 thread_count, void *(*proc)(void *)) {
+    pthread_t threads[MAX_THREADS];
+
+    u64 start = benchmark_now_nanoseconds();
+
+    for (s64 index = 0; index < thread_count; ++index) {
+        pthread_create(&threads[index], null, proc, &workers[index]);
+    }
+
+    for (s64 index = 0; index < thread_count; ++index) {
+        pthread_join(threads[index], null);
+    }
+
+    return benchmark_seconds_since(start);
+}
+
+// Checks the stamps, a block handed out twice holds the stamp of the last writer.
+static bool bump_check_and_free(Worker *workers, s64 thread_count) {
+    bool result = true;
+
+    for (s64 index = 0; index < thread_count; ++index) {
+        Worker *worker = &workers[index];
+
+        for (s64 block = 0; block < BLOCKS_PER_THREAD; ++block) {
+            u8 *it = worker->blocks[block];
+
+            for (s64 byte = 0; byte < worker->sizes[block]; ++byte) {
+                if (it[byte] != worker->stamp) result = false;
+            }
+
+            if (worker->source == BUMP_HEAP) heap_free(it);
+        }
+    }
+
+    return result;
+}
+
+static float64 bump(Worker *workers, s64 thread_count, Bump_Source source, Concurrent_Pool *pool, Numa_Pool_Registry *registry, bool *ok) {
+    for (s64 index = 0; index < thread_count; ++index) {
+        workers[index].source   = source;
+        workers[index].pool     = pool;
+        workers[index].registry = registry;
+        workers[index].stamp    = (u8)(index + 1);
+        workers[index].seed     = (u32)(index + 1) * 7919u;
+    }
+
+    float64 seconds = run(workers, thread_count, bump_proc);
+    if (!bump_check_and_free(workers, thread_count)) *ok = false;
+
+    if (source == BUMP_CONCURRENT_POOL) concurrent_pool_reset(pool);
+    if (source == BUMP_NUMA_REGISTRY) numa_pool_registry_reset(registry);
+
+    return seconds;
+}
+
+static float64 churn(Worker *workers, s64 thread_count, Allocator a) {
+    for (s64 index = 0; index < thread_count; ++index) {
+        workers[index].allocator = a;
+        workers[index].seed      = (u32)(index + 1) * 7919u;
+    }
+
+    return run(workers, thread_count, churn_proc);
+}
+
+int main(void) {
+    Worker workers[MAX_THREADS];
+    for (s64 index = 0; index < MAX_THREADS; ++index) {
+        workers[index].blocks = (u8 **)heap_alloc(BLOCKS_PER_THREAD * size_of(u8 *));
+        workers[index].sizes  = (s64 *)heap_alloc(BLOCKS_PER_THREAD * size_of(s64));
+    }
+
+    Concurrent_Pool pool;
+    concurrent_pool_init(&pool);
+
+    Numa_Pool_Registry *registry = New(Numa_Pool_Registry);
+    numa_pool_registry_init(registry);
+
+    print("%lld NUMA nodes, main thread on node %lld\n\n", numa_node_count(), numa_current_node());
+
+    bool ok = true;
+
+    print("Bump allocation (Mallocs/s)\n");
+    print("%8s %12s %16s %16s\n", "threads", "heap", "concurrent pool", "numa registry");
+
+    for (s64 thread_count = 1; thread_count <= MAX_THREADS; thread_count *= 2) {
+        float64 allocations = (float64)(thread_count * BLOCKS_PER_THREAD) / 1e6;
+
+        float64 heap_seconds     = bump(workers, thread_count, BUMP_HEAP, null, null, &ok);
+        float64 pool_seconds     = bump(workers, thread_count, BUMP_CONCURRENT_POOL, &pool, null, &ok);
+        float64 registry_seconds = bump(workers, thread_count, BUMP_NUMA_REGISTRY, null, registry, &ok);
+
+        print("%8lld %12.2f %16.2f %16.2f\n", thread_count,
+              allocations / heap_seconds, allocations / pool_seconds, allocations / registry_seconds);
+    }
+
+    s64 bound = 0, unbound = 0;
+    for (s64 node = 0; node < registry->node_count; ++node) {
+        bound   += registry->block_allocators[node].bound_blocks;
+        unbound += registry->block_allocators[node].unbound_blocks;
+    }
+
+    print("registry blocks: %lld bound to their node, %lld unbound\n", bound, unbound);
+    print("stamps: %s\n\n", ok ? "ok" : "FAILED, blocks were handed out twice");
+
+    Allocation_Stats *stats = NewAligned(Allocation_Stats, 64);
+    allocation_stats_init(stats, {heap_allocator, null}, "churn");
+
+    print("Churn (Mops/s)\n");
+    print("%8s %12s %16s\n", "threads", "heap", "stats(heap)");
+
+    for (s64 thread_count = 1; thread_count <= MAX_THREADS; thread_count *= 2) {
+        float64 operations = (float64)(thread_count * OPERATIONS_PER_THREAD) / 1e6;
+
+        float64 heap_seconds  = churn(workers, thread_count, {heap_allocator, null});
+        float64 stats_seconds = churn(workers, thread_count, {allocation_stats_proc, stats});
+
+        print("%8lld %12.2f %16.2f\n", thread_count, operations / heap_seconds, operations / stats_seconds);
+    }
+
+    print("\n");
+    allocation_stats_dump(stats, 4);
+
+    numa_pool_registry_release(registry);
+    concurrent_pool_release(&pool);
+
+    for (s64 index = 0; index < MAX_THREADS; ++index) {
+        heap_free(workers[index].blocks);
+        heap_free(workers[index].sizes);
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,79 @@
+/*
+
+    Grows large Array<T>s one element at a time and compares heap_allocator
+    against an allocator that resizes the way the Windows backend does:
+    allocate, zero, copy, free.
+
+    g++ -O2 -o heap_resize heap_resize.cpp
+
+*/
+
+#include "benchmark.h"
+#include "../array.h"
+
+#include <stdlib.h>
+
+static s64 copied_bytes = 0;
+
+static ALLOCATOR_PROC(copying_allocator) {
+    UNUSED(allocator_data);
+
+    switch (mode) {
+        case ALLOCATOR_ALLOCATE:
+        case ALLOCATOR_ALLOCATE_UNINITIALIZED:
+            return calloc(1, (size_t)size);
+
+        case ALLOCATOR_RESIZE: {
+            void *result = calloc(1, (size_t)size);
+            if (!result) return null;
+
+            if (old_memory) {
+                memcpy(result, old_memory, (umm)Min(old_size, size));
+                copied_bytes += Min(old_size, size);
+                free(old_memory);
+            }
+
+            return result;
+        } break;
+
+        case ALLOCATOR_FREE:
+            free(old_memory);
+            return null;
+
+        default:
+            return null;
+    }
+}
+
+static float64 grow_array(s64 count, Allocator a) {
+    u64 start = benchmark_now_nanoseconds();
+
+    Array<u64> array = {};
+    array.allocator = a;
+
+    for (s64 index = 0; index < count; ++index) {
+        array_add(&array, (u64)index);
+    }
+
+    float64 seconds = benchmark_seconds_since(start);
+
+    if (array.data[count-1] != (u64)(count-1)) write_string("Mismatch!\n", true);
+    array_free(&array);
+
+    return seconds;
+}
+
+int main(void) {
+    print("%12s %14s %14s %16s\n", "elements", "heap (ms)", "copying (ms)", "bytes copied");
+
+    for (s64 count = 1 << 16; count <= (1 << 27); count <<= 1) {
+        float64 heap_seconds = grow_array(count, {heap_allocator, null});
+
+        copied_bytes = 0;
+        float64 copying_seconds = grow_array(count, {copying_allocator, null});
+
+        print("%12lld %14.2f %14.2f %16lld\n", count, heap_seconds * 1000.0, copying_seconds * 1000.0, copied_bytes);
+    }
+
+    return 0;
+}
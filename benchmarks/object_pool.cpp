@@ -0,0 +1,86 @@
+/*
+
+    Fixed size object churn, heap_alloc / heap_free against an
+    Object_Pool with its intrusive free list.
+
+    g++ -O2 -o object_pool object_pool.cpp
+
+*/
+
+#include "benchmark.h"
+
+#define POOL_IMPLEMENTATION
+#include "../pool.h"
+
+#include <stdio.h>
+
+const s64 OPERATIONS = 20000000;
+const s64 LIVE_OBJECTS = 100000;
+
+struct Message {
+    s64 id;
+    s64 sender;
+    u8 payload[48];
+};
+
+static Message *live[LIVE_OBJECTS];
+
+static float64 run_heap(void) {
+    memory_zero(live, size_of(live));
+    u64 start = benchmark_now_nanoseconds();
+
+    u32 seed = 1;
+    for (s64 index = 0; index < OPERATIONS; ++index) {
+        seed = seed * 1664525u + 1013904223u;
+        s64 slot = (s64)((seed >> 8) % LIVE_OBJECTS);
+
+        if (live[slot]) heap_free(live[slot]);
+        live[slot] = (Message *)heap_alloc(size_of(Message));
+        live[slot]->id = index;
+    }
+
+    float64 result = benchmark_seconds_since(start);
+
+    for (s64 index = 0; index < LIVE_OBJECTS; ++index) {
+        if (live[index]) heap_free(live[index]);
+    }
+
+    return result;
+}
+
+static float64 run_object_pool(void) {
+    memory_zero(live, size_of(live));
+
+    Object_Pool<Message> op;
+    object_pool_init(&op);
+
+    u64 start = benchmark_now_nanoseconds();
+
+    u32 seed = 1;
+    for (s64 index = 0; index < OPERATIONS; ++index) {
+        seed = seed * 1664525u + 1013904223u;
+        s64 slot = (s64)((seed >> 8) % LIVE_OBJECTS);
+
+        if (live[slot]) object_pool_put(&op, live[slot]);
+        live[slot] = object_pool_get(&op);
+        live[slot]->id = index;
+    }
+
+    float64 result = benchmark_seconds_since(start);
+
+    Pool_Stats stats = pool_get_stats(&op.pool);
+    printf("object pool holds %lld objects in %lldkB of memblocks\n",
+           (long long)op.live_count, (long long)(stats.used_bytes / 1024));
+
+    object_pool_release(&op);
+    return result;
+}
+
+int main(void) {
+    float64 heap_seconds = run_heap();
+    float64 pool_seconds = run_object_pool();
+
+    printf("heap_alloc/heap_free  %.3fs  %.1fns per operation\n", heap_seconds, heap_seconds * 1e9 / (float64)OPERATIONS);
+    printf("object pool           %.3fs  %.1fns per operation\n", pool_seconds, pool_seconds * 1e9 / (float64)OPERATIONS);
+    return 0;
+}
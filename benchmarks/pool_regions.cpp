@@ -0,0 +1,169 @@
+/*
+
+    Pool memblocks from heap_allocator against memblocks carved out of
+    regions with normal pages, transparent huge pages, prefaulted
+    huge pages and reserved huge pages (MAP_HUGETLB).
+
+    The fill phase allocates and touches every object and reports minor
+    page faults, the access phase reads objects at random and reports
+    data TLB misses. TLB misses need perf events, they show as n/a when
+    perf_event_paranoid or a container does not allow them.
+
+    g++ -O2 -o pool_regions pool_regions.cpp
+
+*/
+
+#include "benchmark.h"
+
+#define POOL_IMPLEMENTATION
+#include "../pool.h"
+
+#define REGION_IMPLEMENTATION
+#include "../region.h"
+
+#include <stdio.h>
+#include <sys/resource.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+const s64 OBJECT_SIZE  = 64;
+const s64 OBJECT_COUNT = 4 * 1024 * 1024;  // 256MB worth of objects.
+const s64 ACCESS_COUNT = 32 * 1024 * 1024;
+
+static s64 minor_faults(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (s64)usage.ru_minflt;
+}
+
+static int open_dtlb_miss_counter(void) {
+    struct perf_event_attr attr;
+    memory_zero(&attr, size_of(attr));
+
+    attr.type   = PERF_TYPE_HW_CACHE;
+    attr.size   = size_of(attr);
+    attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled       = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+// Transparent huge pages backing the process right now.
+static s64 anon_huge_kilobytes(void) {
+    FILE *file = fopen("/proc/self/smaps_rollup", "r");
+    if (!file) return -1;
+
+    s64 result = -1;
+    char line[256];
+    while (fgets(line, size_of(line), file)) {
+        long long value;
+        if (sscanf(line, "AnonHugePages: %lld kB", &value) == 1) result = value;
+    }
+
+    fclose(file);
+    return result;
+}
+
+// Maps the regions the fill phase needs before it is timed, a prefaulting
+// region would otherwise fault them in from inside the first pool_get.
+static void region_map_up_front(Region_Allocator *region, s64 size) {
+    s64 count = size / region->block_size + 1;
+
+    Array<u8 *> blocks;
+    array_reserve(&blocks, count);
+    for (s64 index = 0; index < count; ++index) array_add(&blocks, (u8 *)region_take_block(region, false));
+
+    // Freed in reverse, the pool takes them back in address order.
+    for (s64 index = count - 1; index >= 0; --index) region_free_block(region, blocks[index]);
+    array_free(&blocks);
+}
+
+static void run(const char *name, Allocator block_allocator, Region_Allocator *region) {
+    Pool pool;
+    pool_init(&pool);
+    set_allocators(&pool, block_allocator);
+
+    u8 **objects = (u8 **)heap_alloc(OBJECT_COUNT * size_of(u8 *));
+
+    if (region && region->prefault) region_map_up_front(region, OBJECT_COUNT * OBJECT_SIZE);
+
+    s64 faults = minor_faults();
+    u64 start  = benchmark_now_nanoseconds();
+
+    for (s64 index = 0; index < OBJECT_COUNT; ++index) {
+        u8 *it = (u8 *)pool_get(&pool, OBJECT_SIZE);
+        it[0] = (u8)index;
+        objects[index] = it;
+    }
+
+    float64 fill_seconds = benchmark_seconds_since(start);
+    faults = minor_faults() - faults;
+
+    s64 huge_kilobytes = anon_huge_kilobytes();
+
+    int counter = open_dtlb_miss_counter();
+    if (counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+        ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    start = benchmark_now_nanoseconds();
+
+    u32 seed = 12345;
+    u64 sum  = 0;
+    for (s64 index = 0; index < ACCESS_COUNT; ++index) {
+        seed = seed * 1664525u + 1013904223u;
+        sum += objects[seed % OBJECT_COUNT][0];
+    }
+
+    float64 access_seconds = benchmark_seconds_since(start);
+
+    char misses[32] = "n/a";
+    if (counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+
+        long long value = 0;
+        if (read(counter, &value, size_of(value)) == size_of(value)) snprintf(misses, size_of(misses), "%lld", value);
+        close(counter);
+    }
+
+    printf("%-22s fill %7.3fs  faults %8lld  access %7.3fs  dtlb misses %12s  thp %7lldkB  (%llu)\n",
+           name, fill_seconds, (long long)faults, access_seconds, misses, (long long)huge_kilobytes, (unsigned long long)sum);
+
+    if (region && region->use_hugetlb) {
+        printf("%-22s %lld of %lld regions got MAP_HUGETLB pages\n", "",
+               (long long)region->hugetlb_regions, (long long)region->regions.count);
+    }
+
+    pool_release(&pool);
+    array_free(&pool.unused_memblocks);
+    array_free(&pool.used_memblocks);
+    array_free(&pool.out_of_band_allocations);
+    heap_free(objects);
+
+    if (region) region_release(region);
+}
+
+int main(void) {
+    run("heap_allocator", {heap_allocator, null}, null);
+
+    Region_Allocator region;
+    region_init(&region);
+
+    region.huge_pages = false;
+    run("region", {region_allocator_proc, &region}, &region);
+
+    region.huge_pages = true;
+    run("region huge", {region_allocator_proc, &region}, &region);
+
+    region.prefault = true;
+    run("region huge prefault", {region_allocator_proc, &region}, &region);
+
+    region.use_hugetlb = true;
+    run("region hugetlb", {region_allocator_proc, &region}, &region);
+
+    return 0;
+}
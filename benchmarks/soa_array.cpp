@@ -0,0 +1,108 @@
+/*
+
+    Hot loops that touch one or two fields of a 64 byte particle, with
+    the particles in an Array<Particle> and with every field in its own
+    Soa_Array column. The array is bigger than the caches, so the loops
+    are bound by how many bytes they pull in.
+
+    g++ -O2 -o soa_array soa_array.cpp
+    g++ -O3 -march=native -o soa_array soa_array.cpp
+
+*/
+
+#include "benchmark.h"
+#include "../soa_array.h"
+
+const s64 PARTICLE_COUNT = 1 << 20;
+const s64 ROUNDS         = 20;
+
+struct Particle {
+    float32 position[3];
+    float32 velocity[3];
+    float32 mass;
+    u32 id;
+    float32 color[4];
+    u64 flags;
+    u64 owner;
+};
+
+enum { POSITION_X, POSITION_Y, POSITION_Z, VELOCITY_X, VELOCITY_Y, VELOCITY_Z, MASS, ID, COLOR, FLAGS, OWNER };
+
+typedef Soa_Array<float32, float32, float32, float32, float32, float32, float32, u32, u32, u64, u64> Particles;
+
+static float64 checksum = 0;
+
+__attribute__((noinline)) static float32 sum_mass(Array<Particle> *particles) {
+    float32 result = 0;
+    For(*particles) result += it.mass;
+    return result;
+}
+
+__attribute__((noinline)) static float32 sum_mass(Particles *particles) {
+    float32 *mass = soa_column<MASS>(particles);
+
+    float32 result = 0;
+    for (s64 index = 0; index < particles->count; ++index) result += mass[index];
+    return result;
+}
+
+__attribute__((noinline)) static void move_x(Array<Particle> *particles, float32 dt) {
+    For(*particles) it.position[0] += it.velocity[0] * dt;
+}
+
+__attribute__((noinline)) static void move_x(Particles *particles, float32 dt) {
+    float32 *x  = soa_column<POSITION_X>(particles);
+    float32 *vx = soa_column<VELOCITY_X>(particles);
+
+    for (s64 index = 0; index < particles->count; ++index) x[index] += vx[index] * dt;
+}
+
+template<typename P>
+static float64 time_loops(P *particles, bool move) {
+    u64 start = benchmark_now_nanoseconds();
+
+    for (s64 round = 0; round < ROUNDS; ++round) {
+        if (move) {
+            move_x(particles, 0.01f);
+        } else {
+            checksum += sum_mass(particles);
+        }
+    }
+
+    return benchmark_seconds_since(start) * 1000.0 / ROUNDS;
+}
+
+int main(void) {
+    Array<Particle> aos = {};
+    Particles soa;
+
+    for (s64 index = 0; index < PARTICLE_COUNT; ++index) {
+        float32 value = (float32)(index % 1000);
+
+        Particle p = {};
+        p.position[0] = value;
+        p.velocity[0] = 1.0f;
+        p.mass        = value * 0.001f;
+        p.id          = (u32)index;
+        array_add(&aos, p);
+
+        array_add(&soa, value, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, value * 0.001f, (u32)index, 0u, (u64)0, (u64)0);
+    }
+
+    print("%lld particles of %lld bytes\n", PARTICLE_COUNT, (s64)size_of(Particle));
+    print("%-10s %12s %12s %9s\n", "loop", "Array ms", "Soa_Array ms", "speedup");
+
+    float64 aos_ms = time_loops(&aos, false);
+    float64 soa_ms = time_loops(&soa, false);
+    print("%-10s %12.3f %12.3f %8.1fx\n", "sum mass", aos_ms, soa_ms, aos_ms / soa_ms);
+
+    aos_ms = time_loops(&aos, true);
+    soa_ms = time_loops(&soa, true);
+    print("%-10s %12.3f %12.3f %8.1fx\n", "move x", aos_ms, soa_ms, aos_ms / soa_ms);
+
+    print("(%f)\n", checksum);
+
+    array_free(&aos);
+    array_free(&soa);
+    return 0;
+}
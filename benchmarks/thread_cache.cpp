@@ -0,0 +1,86 @@
+/*
+
+    Multi-threaded small block churn, heap_allocator against the
+    thread caching front-end sitting on top of heap_allocator.
+
+    g++ -O2 -pthread -o thread_cache thread_cache.cpp
+
+*/
+
+#include "benchmark.h"
+
+#define THREAD_CACHE_IMPLEMENTATION
+#include "../thread_cache.h"
+
+#include <pthread.h>
+
+const s64 OPERATIONS_PER_THREAD = 4000000;
+const s64 LIVE_BLOCKS           = 256;
+
+struct Worker {
+    Allocator allocator;
+    u32 seed;
+};
+
+static void *worker_proc(void *data) {
+    Worker *worker = (Worker *)data;
+    Allocator a = worker->allocator;
+
+    void *blocks[LIVE_BLOCKS] = {};
+    u32 seed = worker->seed;
+
+    for (s64 index = 0; index < OPERATIONS_PER_THREAD; ++index) {
+        seed = seed * 1664525u + 1013904223u;
+
+        s64 slot = (s64)((seed >> 8) % LIVE_BLOCKS);
+        s64 size = 16 + (s64)((seed >> 16) % 512);
+
+        if (blocks[slot]) a.proc(ALLOCATOR_FREE, 0, 0, blocks[slot], a.data);
+        blocks[slot] = a.proc(ALLOCATOR_ALLOCATE, size, 0, null, a.data);
+    }
+
+    for (s64 index = 0; index < LIVE_BLOCKS; ++index) {
+        if (blocks[index]) a.proc(ALLOCATOR_FREE, 0, 0, blocks[index], a.data);
+    }
+
+    thread_cache_flush();
+    return null;
+}
+
+static float64 run(s64 thread_count, Allocator a) {
+    pthread_t threads[64];
+    Worker workers[64];
+
+    u64 start = benchmark_now_nanoseconds();
+
+    for (s64 index = 0; index < thread_count; ++index) {
+        workers[index].allocator = a;
+        workers[index].seed = (u32)(index + 1) * 7919u;
+        pthread_create(&threads[index], null, worker_proc, &workers[index]);
+    }
+
+    for (s64 index = 0; index < thread_count; ++index) {
+        pthread_join(threads[index], null);
+    }
+
+    return benchmark_seconds_since(start);
+}
+
+int main(void) {
+    Thread_Cache cache;
+    thread_cache_init(&cache);
+
+    print("%8s %16s %16s\n", "threads", "heap (Mops/s)", "cache (Mops/s)");
+
+    for (s64 thread_count = 1; thread_count <= 16; thread_count *= 2) {
+        float64 operations = (float64)(thread_count * OPERATIONS_PER_THREAD) / 1e6;
+
+        float64 heap_seconds  = run(thread_count, {heap_allocator, null});
+        float64 cache_seconds = run(thread_count, {thread_cache_allocator_proc, &cache});
+
+        print("%8lld %16.2f %16.2f\n", thread_count, operations / heap_seconds, operations / cache_seconds);
+    }
+
+    thread_cache_release(&cache);
+    return 0;
+}
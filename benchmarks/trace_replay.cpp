@@ -0,0 +1,154 @@
+/*
+
+    Replays an allocation trace against heap_allocator, Pool, the slab
+    allocator and the thread cache, and reports throughput, peak live
+    bytes, resident memory growth and fragmentation for each.
+
+        trace_replay record <file>   records a sample workload into <file>
+        trace_replay <file>          replays <file>
+
+    Traces of real programs come from wrapping their allocator with
+    allocation_trace_proc, see allocation_trace.h. Every allocator runs in
+    a fresh process, so resident memory of one run does not leak into the
+    next one.
+
+    g++ -O2 -pthread -o trace_replay trace_replay.cpp
+
+*/
+
+#include "benchmark.h"
+
+#define POOL_IMPLEMENTATION
+#include "../pool.h"
+
+#define THREAD_CACHE_IMPLEMENTATION
+#include "../thread_cache.h"
+
+#define ALLOCATION_TRACE_IMPLEMENTATION
+#include "../allocation_trace.h"
+
+#include <stdio.h>
+#include <sys/wait.h>
+
+// A few frames of mixed lifetimes, strings growing by resizes and a long
+// lived set of objects, then everything dropped at the end.
+static void record_sample(const char *file_name) {
+    Allocation_Trace trace;
+    if (!allocation_trace_open(&trace, file_name, {heap_allocator, null})) {
+        printf("Can not write %s\n", file_name);
+        return;
+    }
+
+    Allocator a = {allocation_trace_proc, &trace};
+
+    const s64 LONG_LIVED = 20000;
+    void **long_lived = (void **)heap_alloc(LONG_LIVED * size_of(void *));
+
+    u32 seed = 1;
+    for (s64 frame = 0; frame < 50; ++frame) {
+        void *frame_blocks[2000];
+
+        for (s64 index = 0; index < 2000; ++index) {
+            seed = seed * 1664525u + 1013904223u;
+            frame_blocks[index] = a.proc(ALLOCATOR_ALLOCATE, 16 + (seed >> 20) % 1024, 0, null, a.data);
+
+            s64 slot = (s64)((seed >> 8) % LONG_LIVED);
+            if (long_lived[slot]) a.proc(ALLOCATOR_FREE, 0, 0, long_lived[slot], a.data);
+            long_lived[slot] = a.proc(ALLOCATOR_ALLOCATE, 32 + (seed >> 24) * 16, 0, null, a.data);
+        }
+
+        s64 size = 64;
+        void *text = a.proc(ALLOCATOR_ALLOCATE, size, 0, null, a.data);
+        while (size < (s64)KB(512)) {
+            text = a.proc(ALLOCATOR_RESIZE, size * 2, size, text, a.data);
+            size *= 2;
+        }
+        a.proc(ALLOCATOR_FREE, 0, 0, text, a.data);
+
+        for (s64 index = 0; index < 2000; ++index) a.proc(ALLOCATOR_FREE, 0, 0, frame_blocks[index], a.data);
+    }
+
+    for (s64 index = 0; index < LONG_LIVED; ++index) {
+        if (long_lived[index]) a.proc(ALLOCATOR_FREE, 0, 0, long_lived[index], a.data);
+    }
+    heap_free(long_lived);
+
+    s64 events = trace.events_written + trace.event_count;
+    allocation_trace_close(&trace);
+
+    printf("Recorded %lld events into %s\n", (long long)events, file_name);
+}
+
+static void report(const char *name, Allocation_Trace_Replay_Result result) {
+    printf("%-16s %8.3fs  %10.0f events/s  peak live %9lldkB  resident %9lldkB  fragmentation %5.2f  failed %lld\n",
+           name, result.seconds, (float64)result.events / result.seconds,
+           (long long)(result.peak_live_bytes / 1024), (long long)(result.peak_resident_bytes / 1024),
+           result.fragmentation, (long long)result.failed);
+}
+
+static void replay(const char *name, Allocation_Trace_Event *events, s64 count) {
+    // A child process per allocator, so resident memory starts from the same place.
+    fflush(stdout);
+
+    pid_t pid = fork();
+    if (pid) {
+        int status;
+        waitpid(pid, &status, 0);
+        return;
+    }
+
+    Allocation_Trace_Replay_Result result;
+
+    if (strings_are_equal((char *)name, (char *)"heap_allocator")) {
+        result = allocation_trace_replay(events, count, {heap_allocator, null});
+    } else if (strings_are_equal((char *)name, (char *)"pool")) {
+        Pool pool;
+        pool_init(&pool);
+        result = allocation_trace_replay(events, count, {pool_allocator_proc, &pool});
+        pool_release(&pool);
+    } else if (strings_are_equal((char *)name, (char *)"slab")) {
+        Slab_Allocator slab;
+        slab_init(&slab);
+        result = allocation_trace_replay(events, count, {slab_allocator_proc, &slab});
+        slab_release(&slab);
+    } else {
+        Thread_Cache cache;
+        thread_cache_init(&cache);
+        result = allocation_trace_replay(events, count, {thread_cache_allocator_proc, &cache});
+        thread_cache_release(&cache);
+    }
+
+    report(name, result);
+    fflush(stdout);
+    _exit(0);
+}
+
+int main(int argc, char **argv) {
+    if ((argc == 3) && strings_are_equal(argv[1], (char *)"record")) {
+        record_sample(argv[2]);
+        return 0;
+    }
+
+    if (argc != 2) {
+        printf("Usage: trace_replay record <file>\n");
+        printf("       trace_replay <file>\n");
+        return 1;
+    }
+
+    s64 count = 0;
+    Allocation_Trace_Event *events = allocation_trace_load(argv[1], &count);
+    if (!events) {
+        printf("Can not read a trace from %s\n", argv[1]);
+        return 1;
+    }
+
+    printf("Replaying %lld events from %s\n", (long long)count, argv[1]);
+
+    replay("heap_allocator", events, count);
+    replay("pool", events, count);
+    replay("slab", events, count);
+    replay("thread_cache", events, count);
+
+    heap_free(events);
+    return 0;
+}
@@ -0,0 +1,60 @@
+/*
+
+    Creates buffers that get overwritten right away, the way array_reserve,
+    array_copy and NewArray users do, with zeroed and uninitialized
+    allocations.
+
+    Small buffers come from the malloc heap, where zeroing is a memset.
+    Buffers of HEAP_MAPPED_THRESHOLD bytes or more are mapped, the kernel
+    hands them out zeroed, so the last column shows what an explicit
+    memset on top of that would cost.
+
+    g++ -O2 -o uninitialized_alloc uninitialized_alloc.cpp
+
+*/
+
+#include "benchmark.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+const s64 BYTES_PER_SIZE = GB(1);
+
+static u64 checksum = 0;
+
+static float64 create_buffers(s64 size, s64 count, Allocator_Mode mode, bool memset_first) {
+    u64 start = benchmark_now_nanoseconds();
+
+    for (s64 index = 0; index < count; ++index) {
+        u8 *buffer = (u8 *)heap_allocator(mode, size, 0, null, null);
+        if (memset_first) memory_zero(buffer, (umm)size);
+
+        memset(buffer, (int)(index & 0xff), (umm)size);
+        checksum += buffer[size - 1];
+
+        heap_free(buffer);
+    }
+
+    return (float64)(benchmark_now_nanoseconds() - start) / (float64)count;
+}
+
+int main(void) {
+    s64 sizes[] = {256, KB(4), KB(64), KB(256), MB(1), MB(16)};
+
+    printf("%10s %16s %16s %16s\n", "size", "zeroed ns", "uninit ns", "explicit zero ns");
+
+    for (s64 index = 0; index < (s64)(size_of(sizes) / size_of(sizes[0])); ++index) {
+        s64 size  = sizes[index];
+        s64 count = BYTES_PER_SIZE / size;
+
+        float64 zeroed    = create_buffers(size, count, ALLOCATOR_ALLOCATE, false);
+        float64 uninit    = create_buffers(size, count, ALLOCATOR_ALLOCATE_UNINITIALIZED, false);
+        float64 memsetted = create_buffers(size, count, ALLOCATOR_ALLOCATE_UNINITIALIZED, true);
+
+        printf("%9lldB %16.1f %16.1f %16.1f\n", (long long)size, zeroed, uninit, memsetted);
+    }
+
+    printf("(%llu)\n", (unsigned long long)checksum);
+
+    return 0;
+}
@@ -0,0 +1,314 @@
+#ifndef GENERAL_BUCKET_ARRAY_INCLUDE_H
+#define GENERAL_BUCKET_ARRAY_INCLUDE_H
+/*
+
+    Pointer stable bucket array.
+
+    Items live in buckets of N slots drawn from an Allocator, a Pool is a
+    good fit. The array grows by adding buckets, items never move, so
+    pointers to them stay good until they are removed. Every bucket keeps
+    an occupancy bitmap, removed slots are reused by later adds and
+    iteration skips them a word of the bitmap at a time.
+
+    Adding and removing are O(1). Buckets with a free slot sit on a list,
+    add takes the first free slot of the first of them, remove needs the
+    Bucket_Locator add handed out.
+
+        Bucket_Array<Entity, 64> entities;
+        entities.allocator = {pool_allocator_proc, &pool};
+
+        Bucket_Locator locator;
+        Entity *entity = bucket_array_add(&entities, &locator);
+        ...
+        For(entities) update(&it);
+        ...
+        bucket_array_remove(&entities, locator);
+
+    Buckets stay around when they empty out, bucket_array_free gives them
+    back.
+
+*/
+
+#include "general.h"
+#include "array.h"
+
+
+const s64 BUCKET_ARRAY_ITEMS_DEFAULT = 64;
+
+typedef struct Bucket_Locator {
+    s64 bucket_index = -1;
+    s64 slot_index   = -1;
+} Bucket_Locator;
+
+template<typename T, s64 N>
+struct Bucket_Array_Bucket {
+    static const s64 WORD_COUNT = (N + 31) / 32;
+
+    u32 occupied[WORD_COUNT];  // One bit per slot.
+    s64 count;
+    s64 index;                 // In Bucket_Array::buckets.
+    void *block;               // From the allocator, over-aligned buckets can sit inside it.
+
+    Bucket_Array_Bucket *next_unfull;
+
+    alignas(T) u8 storage[N * size_of(T)];  // Raw, only occupied slots hold constructed items.
+
+    TINYRT_INLINE T *items() { return (T *)this->storage; }
+};
+
+template<typename T, s64 N>
+struct Bucket_Array;
+
+// Walks the occupied slots in bucket order, for (auto &it : array) and For.
+template<typename T, s64 N>
+struct Bucket_Array_Iterator {
+    Bucket_Array<T, N> *array = null;
+
+    s64 bucket_index = 0;
+    s64 word_index   = 0;
+    u32 bits         = 0;  // Slots of the current word not visited yet.
+    T *items         = null;  // Of the current bucket.
+    T *item          = null;
+
+    TINYRT_INLINE T &operator*() { return *this->item; }
+    TINYRT_INLINE bool operator!=(const Bucket_Array_Iterator &other) const { return this->item != other.item; }
+
+    void operator++() {
+        Array<Bucket_Array_Bucket<T, N> *> *buckets = &this->array->buckets;
+
+        while (true) {
+            if (this->bits) {
+                s64 slot = this->word_index * 32 + find_least_significant_set_bit(this->bits);
+                this->bits &= this->bits - 1;
+                this->item = this->items + slot;
+                return;
+            }
+
+            this->word_index += 1;
+            if (this->word_index >= Bucket_Array_Bucket<T, N>::WORD_COUNT) {
+                this->word_index = 0;
+
+                do {
+                    this->bucket_index += 1;
+                } while ((this->bucket_index < buckets->count) && !buckets->data[this->bucket_index]->count);
+
+                if (this->bucket_index < buckets->count) this->items = buckets->data[this->bucket_index]->items();
+            }
+
+            if (this->bucket_index >= buckets->count) {
+                this->item = null;
+                return;
+            }
+
+            this->bits = buckets->data[this->bucket_index]->occupied[this->word_index];
+        }
+    }
+};
+
+template<typename T, s64 N = BUCKET_ARRAY_ITEMS_DEFAULT>
+struct Bucket_Array {
+    static_assert(N > 0, "Bucket_Array needs room for at least one item per bucket.");
+
+    s64 count = 0;
+
+    Array<Bucket_Array_Bucket<T, N> *> buckets;
+    Bucket_Array_Bucket<T, N> *unfull_buckets = null;  // Buckets with a free slot, linked by next_unfull.
+
+    Allocator allocator = {heap_allocator, null};  // Buckets come from here.
+
+    Bucket_Array_Iterator<T, N> begin() {
+        Bucket_Array_Iterator<T, N> result;
+        result.array        = this;
+        result.bucket_index = -1;
+        result.word_index   = Bucket_Array_Bucket<T, N>::WORD_COUNT - 1;
+
+        ++result;
+        return result;
+    }
+
+    Bucket_Array_Iterator<T, N> end() {
+        return {};
+    }
+};
+
+template<typename T, s64 N>
+Bucket_Array_Bucket<T, N> *bucket_array_add_bucket(Bucket_Array<T, N> *array) {
+    typedef Bucket_Array_Bucket<T, N> Bucket;
+
+    if (!array->allocator.proc) {
+        array->allocator.proc = heap_allocator;
+        array->allocator.data = null;
+    }
+
+    Allocator a = array->allocator;
+
+    Bucket *bucket;
+    void *block;
+    if (alignof(Bucket) > 8) {
+        bucket = (Bucket *)allocator_alloc_aligned(a, size_of(Bucket), alignof(Bucket), &block);
+    } else {
+        bucket = (Bucket *)allocator_call(a, ALLOCATOR_ALLOCATE_UNINITIALIZED, size_of(Bucket));
+        block  = bucket;
+    }
+
+    assert(bucket != null);
+    if (!bucket) return null;
+
+    bucket->block = block;
+
+    // Only the header needs clearing, the slots stay raw until they are taken.
+    memory_zero(bucket->occupied, size_of(bucket->occupied));
+    bucket->count = 0;
+    bucket->index = array->buckets.count;
+
+    bucket->next_unfull   = array->unfull_buckets;
+    array->unfull_buckets = bucket;
+
+    array_add(&array->buckets, bucket);
+    return bucket;
+}
+
+// Marks a free slot occupied and returns it, the item is not constructed yet.
+template<typename T, s64 N>
+T *bucket_array_take_slot(Bucket_Array<T, N> *array, Bucket_Locator *locator) {
+    typedef Bucket_Array_Bucket<T, N> Bucket;
+
+    Bucket *bucket = array->unfull_buckets;
+    if (!bucket) bucket = bucket_array_add_bucket(array);
+    if (!bucket) return null;
+
+    s64 slot = -1;
+    for (s64 word = 0; word < Bucket::WORD_COUNT; ++word) {
+        u32 free_slots = ~bucket->occupied[word];
+
+        // Bits past the last slot are never set, keep them out.
+        if ((word == Bucket::WORD_COUNT - 1) && (N % 32)) free_slots &= (1u << (N % 32)) - 1;
+        if (!free_slots) continue;
+
+        u32 bit = find_least_significant_set_bit(free_slots);
+        bucket->occupied[word] |= 1u << bit;
+        slot = word * 32 + bit;
+        break;
+    }
+    assert(slot >= 0);
+
+    bucket->count += 1;
+    array->count  += 1;
+
+    // Buckets fill up at the front of the list.
+    if (bucket->count == N) array->unfull_buckets = bucket->next_unfull;
+
+    if (locator) {
+        locator->bucket_index = bucket->index;
+        locator->slot_index   = slot;
+    }
+
+    return bucket->items() + slot;
+}
+
+template<typename T, s64 N>
+T *bucket_array_add(Bucket_Array<T, N> *array, const T &item, Bucket_Locator *locator = null) {
+    T *result = bucket_array_take_slot(array, locator);
+    if (result) new (result) T(item);
+
+    return result;
+}
+
+template<typename T, s64 N>
+T *bucket_array_add(Bucket_Array<T, N> *array, T &&item, Bucket_Locator *locator = null) {
+    T *result = bucket_array_take_slot(array, locator);
+    if (result) new (result) T(std::move(item));
+
+    return result;
+}
+
+// Hands out a zeroed item, or a default constructed one if T has constructors.
+template<typename T, s64 N>
+T *bucket_array_add(Bucket_Array<T, N> *array, Bucket_Locator *locator = null) {
+    T *result = bucket_array_take_slot(array, locator);
+    if (!result) return null;
+
+    if (array_items_are_trivial<T>()) {
+        memory_zero((void *)result, size_of(T));
+    } else {
+        new (result) T();
+    }
+
+    return result;
+}
+
+// null if the slot is empty.
+template<typename T, s64 N>
+T *bucket_array_find(Bucket_Array<T, N> *array, Bucket_Locator locator) {
+    if ((locator.bucket_index < 0) || (locator.bucket_index >= array->buckets.count)) return null;
+    if ((locator.slot_index < 0) || (locator.slot_index >= N)) return null;
+
+    Bucket_Array_Bucket<T, N> *bucket = array->buckets.data[locator.bucket_index];
+    if (!(bucket->occupied[locator.slot_index / 32] & (1u << (locator.slot_index % 32)))) return null;
+
+    return bucket->items() + locator.slot_index;
+}
+
+// The slot goes back to the bucket for the next add. False if it was empty.
+template<typename T, s64 N>
+bool bucket_array_remove(Bucket_Array<T, N> *array, Bucket_Locator locator) {
+    T *item = bucket_array_find(array, locator);
+    if (!item) return false;
+
+    array_destroy_items(item, 1);
+
+    Bucket_Array_Bucket<T, N> *bucket = array->buckets.data[locator.bucket_index];
+    bucket->occupied[locator.slot_index / 32] &= ~(1u << (locator.slot_index % 32));
+
+    if (bucket->count == N) {
+        bucket->next_unfull   = array->unfull_buckets;
+        array->unfull_buckets = bucket;
+    }
+
+    bucket->count -= 1;
+    array->count  -= 1;
+    return true;
+}
+
+template<typename T, s64 N>
+void bucket_array_destroy_all_items(Bucket_Array<T, N> *array) {
+    if (std::is_trivially_destructible<T>::value) return;
+
+    For(*array) it.~T();
+}
+
+// Empties every bucket but keeps them for the next adds.
+template<typename T, s64 N>
+void bucket_array_reset(Bucket_Array<T, N> *array) {
+    bucket_array_destroy_all_items(array);
+
+    array->unfull_buckets = null;
+
+    for (s64 index = array->buckets.count - 1; index >= 0; --index) {
+        Bucket_Array_Bucket<T, N> *bucket = array->buckets.data[index];
+        memory_zero(bucket->occupied, size_of(bucket->occupied));
+        bucket->count = 0;
+
+        bucket->next_unfull   = array->unfull_buckets;
+        array->unfull_buckets = bucket;
+    }
+
+    array->count = 0;
+}
+
+template<typename T, s64 N>
+void bucket_array_free(Bucket_Array<T, N> *array) {
+    bucket_array_destroy_all_items(array);
+
+    Allocator a = array->allocator;
+    if (a.proc) {
+        For(array->buckets) a.proc(ALLOCATOR_FREE, 0, 0, it->block, a.data);
+    }
+
+    array_free(&array->buckets);
+
+    array->unfull_buckets = null;
+    array->count          = 0;
+}
+
+#endif  // GENERAL_BUCKET_ARRAY_INCLUDE_H
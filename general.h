@@ -232,7 +232,7 @@ typedef u8  b8;   // For consistency.
 #if COMPILER_CL
 #define TINYRT_INLINE __forceinline
 #elif COMPILER_CLANG
-#define TINYRT_INLINE __attribute__((always_inline))
+#define TINYRT_INLINE __attribute__((always_inline)) inline
 #elif COMPILER_GCC
 #define TINYRT_INLINE __attribute__((always_inline)) inline
 #else
@@ -456,6 +456,87 @@ static_assert(size_of(b64) == 8, "size_of(b64) == 8");
 #define memory_zero_array(p)  memory_zero((p), size_of(p))
 
 
+// Atomics, all of them are sequentially consistent.
+#if COMPILER_CL
+#define cpu_relax() _mm_pause()
+#elif ARCH_X64 || ARCH_X86
+#define cpu_relax() __builtin_ia32_pause()
+#else
+#define cpu_relax() ((void)0)
+#endif
+
+inline s64 atomic_load(volatile s64 *pointer) {
+#if COMPILER_CL
+    return _InterlockedCompareExchange64(pointer, 0, 0);
+#else
+    return __atomic_load_n(pointer, __ATOMIC_SEQ_CST);
+#endif
+}
+
+inline void *atomic_load_pointer(void *volatile *pointer) {
+#if COMPILER_CL
+    return _InterlockedCompareExchangePointer(pointer, null, null);
+#else
+    return __atomic_load_n(pointer, __ATOMIC_SEQ_CST);
+#endif
+}
+
+inline void atomic_store(volatile s64 *pointer, s64 value) {
+#if COMPILER_CL
+    _InterlockedExchange64(pointer, value);
+#else
+    __atomic_store_n(pointer, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+inline void atomic_store_pointer(void *volatile *pointer, void *value) {
+#if COMPILER_CL
+    _InterlockedExchangePointer(pointer, value);
+#else
+    __atomic_store_n(pointer, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+// Returns the value before the addition.
+inline s64 atomic_fetch_add(volatile s64 *pointer, s64 value) {
+#if COMPILER_CL
+    return _InterlockedExchangeAdd64(pointer, value);
+#else
+    return __atomic_fetch_add(pointer, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+inline bool atomic_compare_and_swap(volatile s64 *pointer, s64 old_value, s64 new_value) {
+#if COMPILER_CL
+    return _InterlockedCompareExchange64(pointer, new_value, old_value) == old_value;
+#else
+    return __atomic_compare_exchange_n(pointer, &old_value, new_value, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#endif
+}
+
+inline bool atomic_compare_and_swap_pointer(void *volatile *pointer, void *old_value, void *new_value) {
+#if COMPILER_CL
+    return _InterlockedCompareExchangePointer(pointer, new_value, old_value) == old_value;
+#else
+    return __atomic_compare_exchange_n(pointer, &old_value, new_value, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#endif
+}
+
+typedef struct Spin_Lock {
+    volatile s64 locked;
+} Spin_Lock;
+
+inline void spin_lock(Spin_Lock *lock) {
+    while (!atomic_compare_and_swap(&lock->locked, 0, 1)) {
+        while (atomic_load(&lock->locked)) cpu_relax();
+    }
+}
+
+inline void spin_unlock(Spin_Lock *lock) {
+    atomic_store(&lock->locked, 0);
+}
+
+
 typedef enum Operating_System {
     OPERATING_SYSTEM_NONE,
     OPERATING_SYSTEM_WINDOWS,
@@ -482,8 +563,39 @@ typedef enum Allocator_Mode {
     ALLOCATOR_RESIZE,
     ALLOCATOR_FREE,
     ALLOCATOR_FREE_ALL,
+
+    // The modes below are opt-in, procs written without them assert on them.
+    // Procs that answer them say so with allocator_declare_extended_modes,
+    // and allocator_call only sends them there.
+
+    // old_size carries the alignment, a power of 2.
+    // The memory is freed and resized like any other allocation. A resize
+    // that moves the block keeps the alignment where the allocator keeps a
+    // block header. Pool, Concurrent_Pool and temporary storage only keep
+    // their own alignment, do not resize over-aligned blocks there.
+    ALLOCATOR_ALLOCATE_ALIGNED,
+
+    // Like ALLOCATOR_ALLOCATE, but the memory may hold garbage. For buffers
+    // that get overwritten right away, allocators that always zero treat it
+    // as ALLOCATOR_ALLOCATE.
+    ALLOCATOR_ALLOCATE_UNINITIALIZED,
+
+    // Returns the Allocator_Caps flags of the allocator, cast to a pointer.
+    ALLOCATOR_CAPS,
+
+    // old_memory is a block that was asked for size bytes. Returns how many bytes
+    // it can really hold, cast to a pointer, or null if the allocator can not tell.
+    ALLOCATOR_USABLE_SIZE,
 } Allocator_Mode;
 
+typedef enum Allocator_Caps {
+    ALLOCATOR_CAPS_FREE            = 0x1,   // ALLOCATOR_FREE gives back any block.
+    ALLOCATOR_CAPS_FREE_ALL        = 0x2,
+    ALLOCATOR_CAPS_RESIZE_IN_PLACE = 0x4,   // ALLOCATOR_RESIZE can keep the address.
+    ALLOCATOR_CAPS_USABLE_SIZE     = 0x8,   // ALLOCATOR_USABLE_SIZE is answered.
+    ALLOCATOR_CAPS_ZEROED          = 0x10,  // ALLOCATOR_ALLOCATE memory is zeroed.
+} Allocator_Caps;
+
 #define ALLOCATOR_PROC(name) void *name(Allocator_Mode mode, s64 size, s64 old_size, void *old_memory, void *allocator_data)
 
 typedef ALLOCATOR_PROC(Allocator_Proc);
@@ -499,11 +611,19 @@ extern thread_var Allocator current_allocator;
 #define GET_ALLOCATOR() (current_allocator)
 
 // Heap allocator.
+// Outside Windows, blocks of HEAP_MAPPED_THRESHOLD bytes or more are mapped directly
+// from the OS so ALLOCATOR_RESIZE can grow them in place by remapping pages.
+// On Windows only zeroed blocks that big are mapped, fresh pages come zeroed
+// from the OS, so they skip the memset.
+const s64 HEAP_MAPPED_THRESHOLD = KB(256);
+
 TINYRT_EXTERN void *heap_allocator(Allocator_Mode mode, s64 size, s64 old_size, void *old_memory, void *allocator_data);
 
 #define heap_alloc(s) heap_allocator(ALLOCATOR_ALLOCATE, (s), 0, null, null)
 #define heap_realloc(mem, size, old_size) heap_allocator(ALLOCATOR_RESIZE, (size), (old_size), (mem), null)
 #define heap_free(mem) heap_allocator(ALLOCATOR_FREE, 0, 0, (mem), null)
+#define heap_alloc_aligned(s, alignment) heap_allocator(ALLOCATOR_ALLOCATE_ALIGNED, (s), (alignment), null, null)
+#define heap_alloc_uninitialized(s) heap_allocator(ALLOCATOR_ALLOCATE_UNINITIALIZED, (s), 0, null, null)
 
 #if COMPILER_CL
 #define New(Type, ...) (Type *)core_new_alloc(size_of(Type), __VA_ARGS__)
@@ -517,6 +637,24 @@ TINYRT_EXTERN void *heap_allocator(Allocator_Mode mode, s64 size, s64 old_size,
 #define NewArray(Type, count, ...) (Type *)core_new_alloc((count) * size_of(Type), ##__VA_ARGS__)
 #endif
 
+#if COMPILER_CL
+#define NewArrayUninitialized(Type, count, ...) (Type *)core_new_alloc_uninitialized((count) * size_of(Type), __VA_ARGS__)
+#else
+#define NewArrayUninitialized(Type, count, ...) (Type *)core_new_alloc_uninitialized((count) * size_of(Type), ##__VA_ARGS__)
+#endif
+
+#if COMPILER_CL
+#define NewAligned(Type, alignment, ...) (Type *)core_new_alloc_aligned(size_of(Type), (alignment), __VA_ARGS__)
+#else
+#define NewAligned(Type, alignment, ...) (Type *)core_new_alloc_aligned(size_of(Type), (alignment), ##__VA_ARGS__)
+#endif
+
+#if COMPILER_CL
+#define NewArrayAligned(Type, count, alignment, ...) (Type *)core_new_alloc_aligned((count) * size_of(Type), (alignment), __VA_ARGS__)
+#else
+#define NewArrayAligned(Type, count, alignment, ...) (Type *)core_new_alloc_aligned((count) * size_of(Type), (alignment), ##__VA_ARGS__)
+#endif
+
 #if COMPILER_CL
 #define MemRealloc(m, new_size, old_size, ...) core_mem_realloc((m), (new_size), (old_size), __VA_ARGS__)
 #else
@@ -531,23 +669,79 @@ TINYRT_EXTERN void *heap_allocator(Allocator_Mode mode, s64 size, s64 old_size,
 
 
 
+/******** Virtual Memory ********/
+TINYRT_EXTERN s64 os_get_page_size(void);
+
+// Reserved memory is not accessible until it is committed,
+// sizes and addresses must be multiples of the page size.
+TINYRT_EXTERN void *os_reserve_memory(s64 size);
+TINYRT_EXTERN bool os_commit_memory(void *memory, s64 size);
+TINYRT_EXTERN void os_decommit_memory(void *memory, s64 size);
+TINYRT_EXTERN void os_release_memory(void *memory, s64 size);
+
+// Gives the pages of committed memory back to the OS but keeps the range usable,
+// the contents are undefined afterwards. Only whole pages inside the range are purged.
+TINYRT_EXTERN void os_purge_memory(void *memory, s64 size);
+
+
 /******** Temporary Storage ********/
 const s64 TEMPORARY_STORAGE_SIZE_DEFAULT = KB(40);
 
+// Without a backing allocator the storage reserves reserve_size bytes of
+// address space and commits it on demand. Every thread reserves one for
+// temporary_storage and one per scratch arena, so keep it modest, past the
+// reservation the storage chains heap blocks like a buffer would.
+#if ARCH_X64 || ARCH_ARM64
+const s64 TEMPORARY_STORAGE_RESERVE_SIZE = MB(256);
+#else
+const s64 TEMPORARY_STORAGE_RESERVE_SIZE = MB(16);
+#endif
+
+const s64 TEMPORARY_STORAGE_COMMIT_SIZE                = KB(64);
+const s64 TEMPORARY_STORAGE_DECOMMIT_THRESHOLD_DEFAULT = MB(1);
+
+// When a buffer from allocator overflows, more blocks are chained after it.
+// Each block remembers the buffer it replaced so marks can roll back to it.
+typedef struct Temporary_Storage_Block {
+    struct Temporary_Storage_Block *previous;
+
+    u8 *previous_data;
+    s64 previous_size;
+    s64 previous_start;
+
+    s64 capacity;
+    s64 padding;  // Keeps the block memory 16 bytes aligned.
+} Temporary_Storage_Block;
+
 typedef struct Temporary_Storage {
-    s64 size = TEMPORARY_STORAGE_SIZE_DEFAULT;
+    s64 size = TEMPORARY_STORAGE_SIZE_DEFAULT;  // Committed bytes when reserved.
     u8 *data = null;
 
+    // Marks are linear offsets across chained blocks, data[0] is at block_start.
     s64 occupied = 0;
-    s64 high_water_mark = 0;
+    s64 block_start = 0;
+    s64 high_water_mark = 0;  // Highest occupied since the last reset.
 
-    Allocator allocator;
+    // Linear offset of the newest allocation, it can be resized in place or freed.
+    s64 last_allocation = -1;
+
+    s64 reserved = 0;  // Zero when data is a buffer from allocator.
+    s64 reserve_size = TEMPORARY_STORAGE_RESERVE_SIZE;  // Set before first use to reserve more or less.
+    s64 decommit_threshold = TEMPORARY_STORAGE_DECOMMIT_THRESHOLD_DEFAULT;
+
+    Temporary_Storage_Block *current_block = null;  // Null while data is the first buffer.
+    Temporary_Storage_Block *unused_blocks = null;  // Rolled back blocks kept for reuse.
+
+    // Set it to get buffers of size bytes instead of reserving.
+    Allocator allocator = {null, null};
 } Temporary_Storage;
 
 extern thread_var Temporary_Storage temporary_storage;
 extern thread_var Allocator temporary_allocator;
 
 TINYRT_EXTERN ALLOCATOR_PROC(temporary_storage_proc);
+TINYRT_EXTERN void temporary_storage_decommit(Temporary_Storage *ts, s64 keep_committed);
+TINYRT_EXTERN void temporary_storage_pop_blocks(Temporary_Storage *ts, s64 mark);
 
 
 /******** String ********/
@@ -628,21 +822,132 @@ TINYRT_EXTERN void set_console_text_color(System_Console_Text_Color color, bool
 TINYRT_EXTERN void set_console_text_color_ansi(System_Console_Text_Color color, bool to_standard_error = false);
 
 // Temporary storage helpers.
+inline void temporary_storage_set_mark(Temporary_Storage *ts, s64 mark) {
+    assert(mark >= 0);
+    assert(mark <= ts->block_start + ts->size);
+
+    if (mark < ts->block_start) {
+        temporary_storage_pop_blocks(ts, mark);
+    }
+
+    if (mark <= ts->last_allocation) ts->last_allocation = -1;
+    ts->occupied = mark;
+}
+
+inline void temporary_storage_reset(Temporary_Storage *ts) {
+    temporary_storage_set_mark(ts, 0);
+    ts->high_water_mark = 0;
+
+    if (ts->reserved && (ts->size > ts->decommit_threshold)) {
+        temporary_storage_decommit(ts, ts->decommit_threshold);
+    }
+}
+
 inline s64 get_temporary_storage_mark(void) {
     return temporary_storage.occupied;
 }
 
 inline void set_temporary_storage_mark(s64 mark) {
-    assert(mark >= 0);
-    assert(mark <= temporary_storage.size);
-    temporary_storage.occupied = mark;
+    temporary_storage_set_mark(&temporary_storage, mark);
 }
 
 inline void reset_temporary_storage(void) {
-    set_temporary_storage_mark(0);
-    temporary_storage.high_water_mark = 0;
+    temporary_storage_reset(&temporary_storage);
+}
+
+
+// Scratch arenas.
+//
+// Every thread has a few temporary storages apart from temporary_storage.
+// scratch_begin hands out one that is not in conflicts, pass it the
+// allocators your caller gave you, so rolling back your scratch never
+// rolls back memory the caller is still building. Nothing else allocates
+// from these, so tprint in between does not interleave with them either.
+//
+//     Scratch scratch = scratch_begin(&caller_allocator, 1);
+//     Array<u32> indices;
+//     indices.allocator = scratch.allocator;
+//     ...
+//     scratch_end(&scratch);
+//
+// Scratch memory belongs to the thread that got it.
+
+const s64 SCRATCH_ARENA_COUNT = 2;
+
+extern thread_var Temporary_Storage scratch_arenas[SCRATCH_ARENA_COUNT];
+
+typedef struct Scratch {
+    Temporary_Storage *storage;  // Null when every arena conflicted.
+    s64 mark;
+
+    Allocator allocator;
+} Scratch;
+
+inline Scratch scratch_begin(Allocator *conflicts = null, s64 conflict_count = 0) {
+    Scratch result;
+
+    for (s64 index = 0; index < SCRATCH_ARENA_COUNT; ++index) {
+        Temporary_Storage *ts = &scratch_arenas[index];
+
+        bool conflict = false;
+        for (s64 it = 0; it < conflict_count; ++it) {
+            if ((conflicts[it].proc == temporary_storage_proc) && (conflicts[it].data == ts)) {
+                conflict = true;
+                break;
+            }
+        }
+
+        if (conflict) continue;
+
+        result.storage = ts;
+        result.mark    = ts->occupied;
+
+        result.allocator.proc = temporary_storage_proc;
+        result.allocator.data = ts;
+        return result;
+    }
+
+    // More nesting than arenas, the caller gets the heap and has to free.
+    assert(!"Every scratch arena conflicts, raise SCRATCH_ARENA_COUNT.");
+
+    result.storage = null;
+    result.mark    = 0;
+
+    result.allocator.proc = heap_allocator;
+    result.allocator.data = null;
+    return result;
+}
+
+inline Scratch scratch_begin(Allocator conflict) {
+    return scratch_begin(&conflict, 1);
+}
+
+// Gives back everything allocated from the scratch since scratch_begin.
+inline void scratch_end(Scratch *scratch) {
+    if (scratch->storage) temporary_storage_set_mark(scratch->storage, scratch->mark);
+}
+
+// Call it once in a while, at the end of a frame for example.
+inline void reset_scratch_arenas(void) {
+    for (s64 index = 0; index < SCRATCH_ARENA_COUNT; ++index) {
+        temporary_storage_reset(&scratch_arenas[index]);
+    }
 }
 
+#if LANGUAGE_CPP
+// Ends the scratch when it goes out of scope.
+struct Scratch_Scope {
+    Scratch scratch;
+
+    Scratch_Scope(Allocator *conflicts = null, s64 conflict_count = 0) { scratch = scratch_begin(conflicts, conflict_count); }
+    Scratch_Scope(Allocator conflict) { scratch = scratch_begin(&conflict, 1); }
+    ~Scratch_Scope() { scratch_end(&scratch); }
+
+    Scratch_Scope(const Scratch_Scope &) = delete;
+    Scratch_Scope &operator=(const Scratch_Scope &) = delete;
+};
+#endif
+
 
 /*
 
@@ -704,12 +1009,70 @@ inline u32 safe_truncate_u64(u64 value) {
 
 
 
-inline void *core_new_alloc(s64 size, Allocator a = GET_ALLOCATOR()) {
+const s64 ALLOCATOR_EXTENDED_PROC_COUNT = 64;  // Procs that can declare the extended modes.
+
+// heap_allocator and temporary_storage_proc know the extended modes without declaring them.
+// Returns false when the table is full, the proc then only gets the basic modes.
+// allocator_call scans the table, declare a few fixed procs, not one per template instance.
+TINYRT_EXTERN bool allocator_declare_extended_modes(Allocator_Proc *proc);
+TINYRT_EXTERN bool allocator_knows_extended_modes(Allocator_Proc *proc);
+
+// Sends mode to a. Procs that did not declare the extended modes get
+// ALLOCATOR_ALLOCATE instead of ALLOCATOR_ALLOCATE_UNINITIALIZED, and null
+// for ALLOCATOR_CAPS and ALLOCATOR_USABLE_SIZE without being called.
+// ALLOCATOR_ALLOCATE_ALIGNED asserts there, the block could not be freed
+// through them, allocator_alloc_aligned works with any proc.
+TINYRT_INLINE void *allocator_call(Allocator a, Allocator_Mode mode, s64 size, s64 old_size = 0, void *old_memory = null) {
+    assert(a.proc != null);
+
+    if ((mode >= ALLOCATOR_ALLOCATE_ALIGNED) && !allocator_knows_extended_modes(a.proc)) {
+        if (mode == ALLOCATOR_ALLOCATE_ALIGNED) {
+            assert(!"ALLOCATOR_ALLOCATE_ALIGNED sent to a proc that did not declare the extended modes, use allocator_alloc_aligned.");
+            return null;
+        }
+
+        if (mode != ALLOCATOR_ALLOCATE_UNINITIALIZED) return null;
+        mode = ALLOCATOR_ALLOCATE;
+    }
+
+    return a.proc(mode, size, old_size, old_memory, a.data);
+}
+
+// Zeroed memory aligned to alignment from any proc. *base is the block to free,
+// it only differs from the result for procs that did not declare the extended
+// modes, they get size + alignment - 1 bytes and the result is aligned by hand.
+TINYRT_INLINE void *allocator_alloc_aligned(Allocator a, s64 size, s64 alignment, void **base) {
+    assert(a.proc != null);
+    assert(is_power_of_2(alignment));
+
+    if (allocator_knows_extended_modes(a.proc)) {
+        *base = a.proc(ALLOCATOR_ALLOCATE_ALIGNED, size, alignment, null, a.data);
+        return *base;
+    }
+
+    *base = a.proc(ALLOCATOR_ALLOCATE, size + alignment - 1, 0, null, a.data);
+    if (!*base) return null;
+
+    return align_forward_pointer(*base, alignment);
+}
+
+// Forced inline, so the return address an allocator proc sees is the line
+// that used New or MemRealloc. allocation_stats_proc keys callsites by it.
+TINYRT_INLINE void *core_new_alloc(s64 size, Allocator a = GET_ALLOCATOR()) {
     assert(a.proc != null);
     return a.proc(ALLOCATOR_ALLOCATE, size, 0, null, a.data);
 }
 
-inline void *core_mem_realloc(void *mem, s64 new_size, s64 old_size, Allocator a = GET_ALLOCATOR()) {
+TINYRT_INLINE void *core_new_alloc_uninitialized(s64 size, Allocator a = GET_ALLOCATOR()) {
+    return allocator_call(a, ALLOCATOR_ALLOCATE_UNINITIALIZED, size);
+}
+
+TINYRT_INLINE void *core_new_alloc_aligned(s64 size, s64 alignment, Allocator a = GET_ALLOCATOR()) {
+    assert(is_power_of_2(alignment));
+    return allocator_call(a, ALLOCATOR_ALLOCATE_ALIGNED, size, alignment);
+}
+
+TINYRT_INLINE void *core_mem_realloc(void *mem, s64 new_size, s64 old_size, Allocator a = GET_ALLOCATOR()) {
     assert(a.proc != null);
     return a.proc(ALLOCATOR_RESIZE, new_size, old_size, mem, a.data);
 }
@@ -719,6 +1082,19 @@ inline void core_memfree(void *mem, Allocator a = GET_ALLOCATOR()) {
     a.proc(ALLOCATOR_FREE, 0, 0, mem, a.data);
 }
 
+// 0 for allocators that did not declare the extended modes.
+inline u32 allocator_caps(Allocator a = GET_ALLOCATOR()) {
+    return (u32)(umm)allocator_call(a, ALLOCATOR_CAPS, 0);
+}
+
+// Never less than size, allocators that can not tell just give size back.
+inline s64 allocator_usable_size(void *mem, s64 size, Allocator a = GET_ALLOCATOR()) {
+    if (!mem) return 0;
+
+    s64 result = (s64)(umm)allocator_call(a, ALLOCATOR_USABLE_SIZE, size, 0, mem);
+    return Max(result, size);
+}
+
 
 /******** Quick Sort ********/
 TINYRT_EXTERN void quick_sort(void *data, s64 count, s64 stride, s64 (*qsort_compare)(void *, void *));
@@ -1056,13 +1432,48 @@ inline void advance(String *s, s64 amount) {
 
 /******** General Implementation ********/
 
-#ifdef GENERAL_IMPLEMENTATION
+#if defined(GENERAL_IMPLEMENTATION) && !defined(GENERAL_IMPLEMENTATION_INCLUDED)
+#define GENERAL_IMPLEMENTATION_INCLUDED
 
 thread_var Logger_Proc *current_logger = default_logger;
 thread_var Allocator current_allocator = {heap_allocator, null};
 
+// The address of a thread local is not a constant on every compiler,
+// so a null data pointer means "this thread's temporary_storage".
 thread_var Temporary_Storage temporary_storage;
-thread_var Allocator temporary_allocator = {temporary_storage_proc, &temporary_storage};
+thread_var Allocator temporary_allocator = {temporary_storage_proc, null};
+
+thread_var Temporary_Storage scratch_arenas[SCRATCH_ARENA_COUNT];
+
+
+static const char *ansi_system_console_text_colors[SYSTEM_TEXT_COUNT] = {
+    "\x1b[30m",   // SYSTEM_TEXT_BLACK
+    "\x1b[34m",   // SYSTEM_TEXT_DARK_BLUE
+    "\x1b[32m",   // SYSTEM_TEXT_DARK_GREEN
+    "\x1b[36m",   // SYSTEM_TEXT_LIGHT_BLUE
+    "\x1b[31m",   // SYSTEM_TEXT_DARK_RED
+    "\x1b[35m",   // SYSTEM_TEXT_MAGENTA
+    "\x1b[33m",   // SYSTEM_TEXT_ORANGE
+    "\x1b[37m",   // SYSTEM_TEXT_LIGHT_GRAY
+    "\x1b[90m",   // SYSTEM_TEXT_GRAY
+    "\x1b[94m",   // SYSTEM_TEXT_BLUE
+    "\x1b[92m",   // SYSTEM_TEXT_GREEN
+    "\x1b[96m",   // SYSTEM_TEXT_CYAN
+    "\x1b[91m",   // SYSTEM_TEXT_RED
+    "\x1b[95m",   // SYSTEM_TEXT_PURPLE
+    "\x1b[93m",   // SYSTEM_TEXT_YELLOW
+    "\x1b[97m",   // SYSTEM_TEXT_WHITE
+};
+
+
+
+// Every heap block starts with this header, it tells us whether the block
+// was mapped directly from the OS and where an aligned block really starts.
+typedef struct Heap_Block_Header {
+    s64 mapped_size;  // Zero unless the block was mapped directly.
+    u32 offset;       // Bytes from the start of the block to this header.
+    u32 alignment;    // Zero unless the block was allocated aligned.
+} Heap_Block_Header;
 
 
 #if OS_WINDOWS
@@ -1102,25 +1513,6 @@ void write_string(String s, bool to_standard_error) {
     UNUSED(status);
 }
 
-static const char *ansi_system_console_text_colors[SYSTEM_TEXT_COUNT] = {
-    "\x1b[30m",   // SYSTEM_TEXT_BLACK
-    "\x1b[34m",   // SYSTEM_TEXT_DARK_BLUE
-    "\x1b[32m",   // SYSTEM_TEXT_DARK_GREEN
-    "\x1b[36m",   // SYSTEM_TEXT_LIGHT_BLUE
-    "\x1b[31m",   // SYSTEM_TEXT_DARK_RED
-    "\x1b[35m",   // SYSTEM_TEXT_MAGENTA
-    "\x1b[33m",   // SYSTEM_TEXT_ORANGE
-    "\x1b[37m",   // SYSTEM_TEXT_LIGHT_GRAY
-    "\x1b[90m",   // SYSTEM_TEXT_GRAY
-    "\x1b[94m",   // SYSTEM_TEXT_BLUE
-    "\x1b[92m",   // SYSTEM_TEXT_GREEN
-    "\x1b[96m",   // SYSTEM_TEXT_CYAN
-    "\x1b[91m",   // SYSTEM_TEXT_RED
-    "\x1b[95m",   // SYSTEM_TEXT_PURPLE
-    "\x1b[93m",   // SYSTEM_TEXT_YELLOW
-    "\x1b[97m",   // SYSTEM_TEXT_WHITE
-};
-
 static u8 w32_system_console_text_colors[SYSTEM_TEXT_COUNT] = {
     0,   // SYSTEM_TEXT_BLACK
     1,   // SYSTEM_TEXT_DARK_BLUE
@@ -1153,58 +1545,674 @@ TINYRT_EXTERN void set_console_text_color_ansi(System_Console_Text_Color color,
     write_string(ansi_system_console_text_colors[color], to_standard_error);
 }
 
-#include <stdio.h>
-
-char *mprint(const char *fmt, ...) {
-    char *result = null;
-    int size = MPRINT_INITIAL_GUESS;
-
-    while (1) {
-        result = NewArray(char, size);
-        if (!result) return null;
-        
-        va_list args;
-        va_start(args, fmt);
-        
-        int len = _vsnprintf(result, size, fmt, args);
-        va_end(args);
-
-        if ((len >= 0) && (size >= len+1)) {
-            size = len;
-            break;
-        }
+TINYRT_EXTERN bool tinyrt_abort_error_message(const char *title, const char *message, const char *details) {
+    char *full_message = tprint("%s%s", message, details);
 
-        MemFree(result);
-        size *= 2;
+    int id = MessageBoxA(null, full_message, title, MB_ABORTRETRYIGNORE | MB_ICONERROR | MB_SYSTEMMODAL | MB_DEFBUTTON3);
+    if (id == IDABORT) {
+        ExitProcess(0);
     }
 
-    return result;
+    return (id == IDRETRY);
 }
 
-char *mprint(int size, const char *fmt, ...) {
-    assert(size > 0);
-    
-    char *result = null;
-
-    while (1) {
-        result = NewArray(char, size);
-        if (!result) return null;
-        
-        va_list args;
-        va_start(args, fmt);
-        
-        int len = _vsnprintf(result, size, fmt, args);
-        va_end(args);
+#if ENABLE_ASSERTS
+#include <dbghelp.h>
+#if COMPILER_CL
+#pragma comment(lib, "Dbghelp.lib")
+#endif
 
-        if ((len >= 0) && (size >= len+1)) {
-            size = len;
-            break;
-        }
 
-        MemFree(result);
-        size *= 2;
+/*
+TINYRT_EXTERN void print_stacktrace(void) {
+    HANDLE process = GetCurrentProcess();
+ 
+    static BOOL initted = false;
+    if (!initted) {
+        initted = SymInitialize(process, null, TRUE);
     }
-
+    
+    if (initted == TRUE) {
+        // Windows Server 2003 and Windows XP: The sum of the FramesToSkip and FramesToCapture parameters must be less than 63.
+        const int MAX_STACK_FRAMES = 63;
+        void *stack[MAX_STACK_FRAMES];
+
+        const int MAX_SYMBOL_NAME = 255;
+        u8 buf[size_of(SYMBOL_INFO) + (MAX_SYMBOL_NAME+1)];
+
+        SYMBOL_INFO *symbol_info = (SYMBOL_INFO *)buf;
+        symbol_info->MaxNameLen = MAX_SYMBOL_NAME;
+        symbol_info->SizeOfStruct = size_of(SYMBOL_INFO);
+
+        SymSetOptions(SYMOPT_LOAD_LINES);
+
+        IMAGEHLP_LINEW64 line64 = {};
+        line64.SizeOfStruct = size_of(IMAGEHLP_LINEW64);
+
+        u16 frames = CaptureStackBackTrace(0, MAX_STACK_FRAMES, stack, null);
+        if (frames > 0) {
+            printf("Caller stack:\n");
+            for (u16 index = 0; index < frames; ++index) {
+                DWORD64 dw_displacement64;
+                BOOL ok = SymFromAddr(process, (DWORD64)(stack[index]), &dw_displacement64, symbol_info);
+                if (!ok) continue;
+
+                s64 call_line;
+                s64 stack_line;
+
+                DWORD64 call_address = (DWORD64)(stack[index]);  // Caller location.
+                DWORD64 stack_address = symbol_info->Address;    // Procedure location.
+
+                DWORD dw_displacement;
+                ok = SymGetLineFromAddrW64(process, call_address, &dw_displacement, &line64);
+                if (!ok) continue;
+
+                call_line = line64.LineNumber;
+
+                ok = SymGetLineFromAddrW64(process, stack_address, &dw_displacement, &line64);
+                if (!ok) continue;
+
+                stack_line = line64.LineNumber;
+
+                printf("0x%016llX: %s(%lld) Line %lld\n", stack_address, symbol_info->Name, stack_line, call_line);
+            }
+        }
+    } else {
+        write_string("[backtrace] Error: Failed to SymInitialize.\n", true);
+    }
+}
+*/
+
+TINYRT_EXTERN char *get_stacktrace(void) {
+    char *result = null;
+    HANDLE process = GetCurrentProcess();
+ 
+    static BOOL initted = false;
+    if (!initted) {
+        initted = SymInitialize(process, null, TRUE);
+        SymSetOptions(SYMOPT_LOAD_LINES);
+    }
+
+    if (initted == TRUE) {
+        // Windows Server 2003 and Windows XP: The sum of the FramesToSkip and FramesToCapture parameters must be less than 63.
+        const int MAX_STACK_FRAMES = 63;
+        void *stack[MAX_STACK_FRAMES];
+
+        const int MAX_SYMBOL_NAME = 255;
+        u8 buf[size_of(SYMBOL_INFO) + (MAX_SYMBOL_NAME+1)];
+
+        SYMBOL_INFO *symbol_info = (SYMBOL_INFO *)buf;
+        symbol_info->MaxNameLen = MAX_SYMBOL_NAME;
+        symbol_info->SizeOfStruct = size_of(SYMBOL_INFO);
+
+        IMAGEHLP_LINEW64 line64 = {};
+        line64.SizeOfStruct = size_of(IMAGEHLP_LINEW64);
+
+        u16 frames = CaptureStackBackTrace(0, MAX_STACK_FRAMES, stack, null);
+        if (frames > 0) {
+            result = tprint("Caller stack:\n");
+            for (u16 index = 0; index < frames; ++index) {
+                DWORD64 dw_displacement64;
+                BOOL ok = SymFromAddr(process, (DWORD64)(stack[index]), &dw_displacement64, symbol_info);
+                if (!ok) continue;
+
+                s64 call_line;
+                s64 stack_line;
+
+                DWORD64 call_address = (DWORD64)(stack[index]);  // Caller location.
+                DWORD64 stack_address = symbol_info->Address;    // Procedure location.
+
+                DWORD dw_displacement;
+                ok = SymGetLineFromAddrW64(process, call_address, &dw_displacement, &line64);
+                if (!ok) continue;
+
+                call_line = line64.LineNumber;
+
+                ok = SymGetLineFromAddrW64(process, stack_address, &dw_displacement, &line64);
+                if (!ok) continue;
+
+                stack_line = line64.LineNumber;
+
+                char *s = tprint("%s0x%016llX: %s(%lld) Line %lld\n", result, stack_address, symbol_info->Name, stack_line, call_line);
+                result = s;
+            }
+        }
+    } else {
+        write_string("[backtrace] Error: Failed to SymInitialize.\n", true);
+    }
+
+    return result;
+}
+#endif  // ENABLE_ASSERTS
+
+
+
+
+TINYRT_EXTERN s64 os_get_page_size(void) {
+    static s64 page_size = 0;
+    if (!page_size) {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        page_size = (s64)info.dwPageSize;
+    }
+
+    return page_size;
+}
+
+TINYRT_EXTERN void *os_reserve_memory(s64 size) {
+    return VirtualAlloc(null, (SIZE_T)size, MEM_RESERVE, PAGE_NOACCESS);
+}
+
+TINYRT_EXTERN bool os_commit_memory(void *memory, s64 size) {
+    return VirtualAlloc(memory, (SIZE_T)size, MEM_COMMIT, PAGE_READWRITE) != null;
+}
+
+TINYRT_EXTERN void os_decommit_memory(void *memory, s64 size) {
+    VirtualFree(memory, (SIZE_T)size, MEM_DECOMMIT);
+}
+
+TINYRT_EXTERN void os_release_memory(void *memory, s64 size) {
+    UNUSED(size);
+    VirtualFree(memory, 0, MEM_RELEASE);
+}
+
+TINYRT_EXTERN void os_purge_memory(void *memory, s64 size) {
+    u8 *first = align_forward_pointer((u8 *)memory, os_get_page_size());
+    u8 *last  = (u8 *)((umm)((u8 *)memory + size) & ~(umm)(os_get_page_size() - 1));
+
+    if (first < last) VirtualAlloc(first, (SIZE_T)(last - first), MEM_RESET, PAGE_READWRITE);
+}
+
+TINYRT_EXTERN void *heap_allocator(Allocator_Mode mode, s64 size, s64 old_size, void *old_memory, void *allocator_data) {
+    UNUSED(allocator_data);
+
+    switch (mode) {
+        case ALLOCATOR_ALLOCATE: {
+            if (size + size_of(Heap_Block_Header) >= HEAP_MAPPED_THRESHOLD) {
+                // Fresh pages come zeroed from the OS, HEAP_ZERO_MEMORY would clear them again.
+                s64 mapped_size = align_forward(size + size_of(Heap_Block_Header), os_get_page_size());
+
+                Heap_Block_Header *header = (Heap_Block_Header *)VirtualAlloc(null, (SIZE_T)mapped_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+                if (!header) return null;
+
+                header->mapped_size = mapped_size;
+                return header + 1;
+            }
+
+            Heap_Block_Header *header = (Heap_Block_Header *)HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, (umm)(size + size_of(Heap_Block_Header)));
+            if (!header) return null;
+
+            return header + 1;
+        } break;
+
+        case ALLOCATOR_ALLOCATE_UNINITIALIZED: {
+            Heap_Block_Header *header = (Heap_Block_Header *)HeapAlloc(GetProcessHeap(), 0, (umm)(size + size_of(Heap_Block_Header)));
+            if (!header) return null;
+
+            header->mapped_size = 0;
+            header->offset      = 0;
+            header->alignment   = 0;
+            return header + 1;
+        } break;
+
+        case ALLOCATOR_ALLOCATE_ALIGNED: {
+            s64 alignment = old_size;
+            assert(is_power_of_2(alignment));
+
+            if (alignment <= MEMORY_ALLOCATION_ALIGNMENT) {
+                return heap_allocator(ALLOCATOR_ALLOCATE, size, 0, null, null);
+            }
+
+            u8 *memory = (u8 *)HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, (umm)(size + alignment + size_of(Heap_Block_Header)));
+            if (!memory) return null;
+
+            u8 *result = align_forward_pointer(memory + size_of(Heap_Block_Header), alignment);
+
+            Heap_Block_Header *header = (Heap_Block_Header *)result - 1;
+            header->offset    = (u32)((u8 *)header - memory);
+            header->alignment = (u32)alignment;
+            return result;
+        } break;
+
+        case ALLOCATOR_RESIZE: {
+            // Allocate, copy, free.
+            s64 alignment = 0;
+            if (old_memory) alignment = ((Heap_Block_Header *)old_memory - 1)->alignment;
+
+            void *result = heap_allocator(alignment ? ALLOCATOR_ALLOCATE_ALIGNED : ALLOCATOR_ALLOCATE_UNINITIALIZED, size, alignment, null, null);
+            if (result == null) return null;
+
+            s64 copied = 0;
+            if (old_memory) {
+                if (old_size > 0) copied = Min(old_size, size);
+                memcpy(result, old_memory, (umm)copied);
+                heap_allocator(ALLOCATOR_FREE, 0, 0, old_memory, null);
+            }
+
+            // Only the bytes past the old contents need zeroing.
+            if (!alignment && (copied < size)) memory_zero((u8 *)result + copied, (umm)(size - copied));
+
+            return result;
+        } break;
+
+        case ALLOCATOR_FREE: {
+            if (!old_memory) return null;
+
+            Heap_Block_Header *header = (Heap_Block_Header *)old_memory - 1;
+
+            if (header->mapped_size) {
+                VirtualFree(header, 0, MEM_RELEASE);
+            } else {
+                HeapFree(GetProcessHeap(), 0, (u8 *)header - header->offset);
+            }
+            return null;
+        } break;
+
+        case ALLOCATOR_FREE_ALL: {
+            // Not supported.
+            assert(!"Not supported");
+            return null;
+        } break;
+
+        case ALLOCATOR_CAPS: {
+            // Resizes always move the block.
+            return (void *)(umm)(ALLOCATOR_CAPS_FREE | ALLOCATOR_CAPS_USABLE_SIZE | ALLOCATOR_CAPS_ZEROED);
+        } break;
+
+        case ALLOCATOR_USABLE_SIZE: {
+            if (!old_memory) return null;
+
+            Heap_Block_Header *header = (Heap_Block_Header *)old_memory - 1;
+
+            s64 capacity = header->mapped_size;
+            if (!capacity) {
+                SIZE_T heap_size = HeapSize(GetProcessHeap(), 0, (u8 *)header - header->offset);
+                if (heap_size == (SIZE_T)-1) return null;
+
+                capacity = (s64)heap_size;
+            }
+
+            return (void *)(umm)(capacity - header->offset - size_of(Heap_Block_Header));
+        } break;
+
+        default: {
+            assert(false);
+            return null;
+        } break;
+    }
+}
+
+#elif OS_LINUX || OS_MAC
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <execinfo.h>
+
+#if OS_MAC
+#include <malloc/malloc.h>
+#define heap_malloc_usable_size(memory) malloc_size(memory)
+#else
+#include <malloc.h>
+#define heap_malloc_usable_size(memory) malloc_usable_size(memory)
+#endif
+
+static void posix_write_all(int fd, const char *s, s64 count) {
+    while (count > 0) {
+        ssize_t written = write(fd, s, (size_t)count);
+        if (written <= 0) break;
+
+        s     += written;
+        count -= written;
+    }
+}
+
+void write_string(const char *s, bool to_standard_error) {
+    posix_write_all(to_standard_error ? STDERR_FILENO : STDOUT_FILENO, s, string_length(s));
+}
+
+void write_string(const char *s, u32 count, bool to_standard_error) {
+    posix_write_all(to_standard_error ? STDERR_FILENO : STDOUT_FILENO, s, count);
+}
+
+void write_string(String s, bool to_standard_error) {
+    posix_write_all(to_standard_error ? STDERR_FILENO : STDOUT_FILENO, (char *)s.data, s.count);
+}
+
+TINYRT_EXTERN void set_console_text_color(System_Console_Text_Color color, bool to_standard_error) {
+    write_string(ansi_system_console_text_colors[color], to_standard_error);
+}
+
+TINYRT_EXTERN void set_console_text_color_ansi(System_Console_Text_Color color, bool to_standard_error) {
+    write_string(ansi_system_console_text_colors[color], to_standard_error);
+}
+
+TINYRT_EXTERN bool tinyrt_abort_error_message(const char *title, const char *message, const char *details) {
+    write_string(title, true);
+    write_string("\n", true);
+    write_string(message, true);
+    if (details) write_string(details, true);
+
+    // There is no dialog to ask the user, so we always break into the debugger.
+    return true;
+}
+
+#if ENABLE_ASSERTS
+TINYRT_EXTERN char *get_stacktrace(void) {
+    const int MAX_STACK_FRAMES = 63;
+    void *stack[MAX_STACK_FRAMES];
+
+    int frames = backtrace(stack, MAX_STACK_FRAMES);
+    if (frames <= 0) return null;
+
+    char **symbols = backtrace_symbols(stack, frames);
+    if (!symbols) return null;
+
+    char *result = tprint("Caller stack:\n");
+    for (int index = 0; index < frames; ++index) {
+        result = tprint("%s%s\n", result, symbols[index]);
+    }
+
+    free(symbols);
+    return result;
+}
+#endif  // ENABLE_ASSERTS
+
+
+TINYRT_EXTERN s64 os_get_page_size(void) {
+    static s64 page_size = 0;
+    if (!page_size) page_size = (s64)sysconf(_SC_PAGESIZE);
+    return page_size;
+}
+
+TINYRT_EXTERN void *os_reserve_memory(s64 size) {
+    void *memory = mmap(null, (size_t)size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (memory == MAP_FAILED) return null;
+    return memory;
+}
+
+TINYRT_EXTERN bool os_commit_memory(void *memory, s64 size) {
+    return mprotect(memory, (size_t)size, PROT_READ | PROT_WRITE) == 0;
+}
+
+TINYRT_EXTERN void os_decommit_memory(void *memory, s64 size) {
+    // Mapping over the range drops the pages and gives the commit charge back.
+    mmap(memory, (size_t)size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+}
+
+TINYRT_EXTERN void os_release_memory(void *memory, s64 size) {
+    munmap(memory, (size_t)size);
+}
+
+TINYRT_EXTERN void os_purge_memory(void *memory, s64 size) {
+    u8 *first = align_forward_pointer((u8 *)memory, os_get_page_size());
+    u8 *last  = (u8 *)((umm)((u8 *)memory + size) & ~(umm)(os_get_page_size() - 1));
+    if (first >= last) return;
+
+#if OS_MAC
+    madvise(first, (size_t)(last - first), MADV_FREE);
+#else
+    madvise(first, (size_t)(last - first), MADV_DONTNEED);
+#endif
+}
+
+
+static void *heap_map_block(s64 size, s64 alignment) {
+    if (alignment < (s64)size_of(Heap_Block_Header)) alignment = (s64)size_of(Heap_Block_Header);
+
+    s64 mapped_size = align_forward(size + alignment, os_get_page_size());
+
+    u8 *memory = (u8 *)mmap(null, (size_t)mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == (u8 *)MAP_FAILED) return null;
+
+    // Fresh pages are zeroed by the kernel.
+    u8 *result = align_forward_pointer(memory + size_of(Heap_Block_Header), alignment);
+
+    Heap_Block_Header *header = (Heap_Block_Header *)result - 1;
+    header->mapped_size = mapped_size;
+    header->offset      = (u32)((u8 *)header - memory);
+    return result;
+}
+
+// Mappings start on a page, so the offset of the header keeps any alignment up to the page size.
+static void *heap_remap_block(Heap_Block_Header *header, s64 size) {
+    u8 *memory = (u8 *)header - header->offset;
+
+    s64 old_mapped_size = header->mapped_size;
+    s64 new_mapped_size = align_forward(size + size_of(Heap_Block_Header) + header->offset, os_get_page_size());
+    if (new_mapped_size == old_mapped_size) return header + 1;
+
+#if OS_LINUX
+    u8 *new_memory = (u8 *)mremap(memory, (size_t)old_mapped_size, (size_t)new_mapped_size, MREMAP_MAYMOVE);
+    if (new_memory == (u8 *)MAP_FAILED) return null;
+
+    header = (Heap_Block_Header *)(new_memory + ((u8 *)header - memory));
+    header->mapped_size = new_mapped_size;
+    return header + 1;
+#else
+    if (new_mapped_size < old_mapped_size) {
+        munmap(memory + new_mapped_size, (size_t)(old_mapped_size - new_mapped_size));
+        header->mapped_size = new_mapped_size;
+        return header + 1;
+    }
+
+    s64 old_capacity = old_mapped_size - header->offset - size_of(Heap_Block_Header);
+
+    void *result = heap_map_block(size, header->alignment);
+    if (!result) return null;
+
+    ((Heap_Block_Header *)result - 1)->alignment = header->alignment;
+
+    memcpy(result, header + 1, (umm)old_capacity);
+    munmap(memory, (size_t)old_mapped_size);
+    return result;
+#endif
+}
+
+TINYRT_EXTERN void *heap_allocator(Allocator_Mode mode, s64 size, s64 old_size, void *old_memory, void *allocator_data) {
+    UNUSED(allocator_data);
+
+    switch (mode) {
+        case ALLOCATOR_ALLOCATE: {
+            if (size + size_of(Heap_Block_Header) >= HEAP_MAPPED_THRESHOLD) {
+                return heap_map_block(size, 0);
+            }
+
+            Heap_Block_Header *header = (Heap_Block_Header *)calloc(1, (size_t)(size + size_of(Heap_Block_Header)));
+            if (!header) return null;
+
+            return header + 1;
+        } break;
+
+        case ALLOCATOR_ALLOCATE_UNINITIALIZED: {
+            // Mapped blocks are zeroed by the kernel either way, small ones skip calloc's memset.
+            if (size + size_of(Heap_Block_Header) >= HEAP_MAPPED_THRESHOLD) {
+                return heap_map_block(size, 0);
+            }
+
+            Heap_Block_Header *header = (Heap_Block_Header *)malloc((size_t)(size + size_of(Heap_Block_Header)));
+            if (!header) return null;
+
+            header->mapped_size = 0;
+            header->offset      = 0;
+            header->alignment   = 0;
+            return header + 1;
+        } break;
+
+        case ALLOCATOR_ALLOCATE_ALIGNED: {
+            s64 alignment = old_size;
+            assert(is_power_of_2(alignment));
+
+            if (alignment <= (s64)alignof(max_align_t)) {
+                return heap_allocator(ALLOCATOR_ALLOCATE, size, 0, null, null);
+            }
+
+            u8 *result = null;
+            if (size + alignment + size_of(Heap_Block_Header) >= HEAP_MAPPED_THRESHOLD) {
+                result = (u8 *)heap_map_block(size, alignment);
+                if (!result) return null;
+            } else {
+                u8 *memory = (u8 *)calloc(1, (size_t)(size + alignment + size_of(Heap_Block_Header)));
+                if (!memory) return null;
+
+                result = align_forward_pointer(memory + size_of(Heap_Block_Header), alignment);
+                ((Heap_Block_Header *)result - 1)->offset = (u32)(result - size_of(Heap_Block_Header) - memory);
+            }
+
+            ((Heap_Block_Header *)result - 1)->alignment = (u32)alignment;
+            return result;
+        } break;
+
+        case ALLOCATOR_RESIZE: {
+            if (!old_memory) return heap_allocator(ALLOCATOR_ALLOCATE, size, 0, null, null);
+
+            Heap_Block_Header *header = (Heap_Block_Header *)old_memory - 1;
+            void *result = null;
+
+            if (header->alignment && !(header->mapped_size && (header->alignment <= os_get_page_size()))) {
+                // realloc does not keep the alignment, move the block by hand.
+                result = heap_allocator(ALLOCATOR_ALLOCATE_ALIGNED, size, header->alignment, null, null);
+                if (!result) return null;
+
+                memcpy(result, old_memory, (umm)Min(old_size, size));
+                heap_allocator(ALLOCATOR_FREE, 0, 0, old_memory, null);
+            } else if (header->mapped_size) {
+                // Only the bytes past old_size inside the old mapping can be dirty,
+                // pages added by the remap come zeroed from the kernel.
+                s64 old_capacity = header->mapped_size - header->offset - size_of(Heap_Block_Header);
+
+                result = heap_remap_block(header, size);
+                if (!result) return null;
+
+                if (old_size < size) {
+                    s64 dirty_end = Min(size, old_capacity);
+                    if (dirty_end > old_size) memory_zero((u8 *)result + old_size, (umm)(dirty_end - old_size));
+                }
+            } else if (size + size_of(Heap_Block_Header) >= HEAP_MAPPED_THRESHOLD) {
+                // Moving out of the malloc heap, later resizes will be remaps.
+                result = heap_map_block(size, 0);
+                if (!result) return null;
+
+                memcpy(result, old_memory, (umm)Min(old_size, size));
+                free(header);
+            } else {
+                header = (Heap_Block_Header *)realloc(header, (size_t)(size + size_of(Heap_Block_Header)));
+                if (!header) return null;
+
+                result = header + 1;
+                if (old_size < size) memory_zero((u8 *)result + old_size, (umm)(size - old_size));
+            }
+
+            return result;
+        } break;
+
+        case ALLOCATOR_FREE: {
+            if (!old_memory) return null;
+
+            Heap_Block_Header *header = (Heap_Block_Header *)old_memory - 1;
+            u8 *memory = (u8 *)header - header->offset;
+
+            if (header->mapped_size) {
+                munmap(memory, (size_t)header->mapped_size);
+            } else {
+                free(memory);
+            }
+
+            return null;
+        } break;
+
+        case ALLOCATOR_FREE_ALL: {
+            // Not supported.
+            assert(!"Not supported");
+            return null;
+        } break;
+
+        case ALLOCATOR_CAPS: {
+            return (void *)(umm)(ALLOCATOR_CAPS_FREE | ALLOCATOR_CAPS_RESIZE_IN_PLACE | ALLOCATOR_CAPS_USABLE_SIZE | ALLOCATOR_CAPS_ZEROED);
+        } break;
+
+        case ALLOCATOR_USABLE_SIZE: {
+            // malloc rounds up to its size classes, mappings to whole pages.
+            if (!old_memory) return null;
+
+            Heap_Block_Header *header = (Heap_Block_Header *)old_memory - 1;
+            u8 *memory = (u8 *)header - header->offset;
+
+            s64 capacity = header->mapped_size;
+            if (!capacity) capacity = (s64)heap_malloc_usable_size(memory);
+
+            return (void *)(umm)(capacity - header->offset - size_of(Heap_Block_Header));
+        } break;
+
+        default: {
+            assert(false);
+            return null;
+        } break;
+    }
+}
+
+#endif  // OS_LINUX || OS_MAC
+
+
+
+#include <stdio.h>
+
+#if OS_WINDOWS
+#define tinyrt_vsnprintf _vsnprintf
+#else
+#define tinyrt_vsnprintf vsnprintf
+#endif
+
+char *mprint(const char *fmt, ...) {
+    char *result = null;
+    int size = MPRINT_INITIAL_GUESS;
+
+    while (1) {
+        result = NewArray(char, size);
+        if (!result) return null;
+        
+        va_list args;
+        va_start(args, fmt);
+        
+        int len = tinyrt_vsnprintf(result, size, fmt, args);
+        va_end(args);
+
+        if ((len >= 0) && (size >= len+1)) {
+            size = len;
+            break;
+        }
+
+        MemFree(result);
+        size *= 2;
+    }
+
+    return result;
+}
+
+char *mprint(int size, const char *fmt, ...) {
+    assert(size > 0);
+    
+    char *result = null;
+
+    while (1) {
+        result = NewArray(char, size);
+        if (!result) return null;
+        
+        va_list args;
+        va_start(args, fmt);
+        
+        int len = tinyrt_vsnprintf(result, size, fmt, args);
+        va_end(args);
+
+        if ((len >= 0) && (size >= len+1)) {
+            size = len;
+            break;
+        }
+
+        MemFree(result);
+        size *= 2;
+    }
+
     return result;
 }
 
@@ -1217,9 +2225,9 @@ TINYRT_EXTERN char *mprint_valist(const char *fmt, va_list arg_list) {
         if (!result) return null;
         
         va_list args;
-        args = arg_list;
+        va_copy(args, arg_list);
         
-        int len = _vsnprintf(result, size, fmt, args);
+        int len = tinyrt_vsnprintf(result, size, fmt, args);
         va_end(args);
 
         if ((len >= 0) && (size >= len+1)) {
@@ -1248,11 +2256,12 @@ TINYRT_EXTERN char *tprint(const char *fmt, ...) {
         va_list args;
         va_start(args, fmt);
         
-        int len = _vsnprintf(result, size, fmt, args);
+        int len = tinyrt_vsnprintf(result, size, fmt, args);
         va_end(args);
 
         if ((len >= 0) && (size >= len+1)) {
-            temporary_storage.occupied -= (size - len - 1);
+            // Give the unused tail back, this shrinks in place.
+            result = (char *)MemRealloc(result, len+1, size, temporary_allocator);
             size = len;
             break;
         }
@@ -1274,13 +2283,14 @@ TINYRT_EXTERN char *tprint_valist(const char *fmt, va_list arg_list) {
         if (!result) return null;
 
         va_list args;
-        args = arg_list;
+        va_copy(args, arg_list);
         
-        int len = _vsnprintf(result, size, fmt, args);
+        int len = tinyrt_vsnprintf(result, size, fmt, args);
         va_end(args);
 
         if ((len >= 0) && (size >= len+1)) {
-            temporary_storage.occupied -= (size - len - 1);
+            // Give the unused tail back, this shrinks in place.
+            result = (char *)MemRealloc(result, len+1, size, temporary_allocator);
             size = len;
             break;
         }
@@ -1304,199 +2314,152 @@ TINYRT_EXTERN void print(const char *fmt, ...) {
     set_temporary_storage_mark(mark);
 }
 
-TINYRT_EXTERN bool tinyrt_abort_error_message(const char *title, const char *message, const char *details) {
-    char *full_message = tprint("%s%s", message, details);
-
-    int id = MessageBoxA(null, full_message, title, MB_ABORTRETRYIGNORE | MB_ICONERROR | MB_SYSTEMMODAL | MB_DEFBUTTON3);
-    if (id == IDABORT) {
-        ExitProcess(0);
-    }
 
-    return (id == IDRETRY);
-}
 
-#if ENABLE_ASSERTS
-#include <dbghelp.h>
-#if COMPILER_CL
-#pragma comment(lib, "Dbghelp.lib")
-#endif
+static bool temporary_storage_init_backing(Temporary_Storage *ts) {
+    if (!ts->allocator.proc) {
+        s64 reserve_size = align_forward(Max(ts->reserve_size, TEMPORARY_STORAGE_COMMIT_SIZE), TEMPORARY_STORAGE_COMMIT_SIZE);
+        ts->data = (u8 *)os_reserve_memory(reserve_size);
 
+        if (ts->data) {
+            ts->reserved = reserve_size;
+            ts->size     = 0;
+            return true;
+        }
 
-/*
-TINYRT_EXTERN void print_stacktrace(void) {
-    HANDLE process = GetCurrentProcess();
- 
-    static BOOL initted = false;
-    if (!initted) {
-        initted = SymInitialize(process, null, TRUE);
+        // No address space to spare, fall back to a fixed buffer.
+        ts->allocator.proc = heap_allocator;
+        ts->allocator.data = null;
     }
-    
-    if (initted == TRUE) {
-        // Windows Server 2003 and Windows XP: The sum of the FramesToSkip and FramesToCapture parameters must be less than 63.
-        const int MAX_STACK_FRAMES = 63;
-        void *stack[MAX_STACK_FRAMES];
 
-        const int MAX_SYMBOL_NAME = 255;
-        u8 buf[size_of(SYMBOL_INFO) + (MAX_SYMBOL_NAME+1)];
+    if (ts->size <= 0) ts->size = TEMPORARY_STORAGE_SIZE_DEFAULT;
 
-        SYMBOL_INFO *symbol_info = (SYMBOL_INFO *)buf;
-        symbol_info->MaxNameLen = MAX_SYMBOL_NAME;
-        symbol_info->SizeOfStruct = size_of(SYMBOL_INFO);
+    ts->data = (u8 *)allocator_call(ts->allocator, ALLOCATOR_ALLOCATE_UNINITIALIZED, ts->size);
+    return ts->data != null;
+}
 
-        SymSetOptions(SYMOPT_LOAD_LINES);
+// Blocks chained past a full reservation come from the heap.
+static inline Allocator temporary_storage_block_allocator(Temporary_Storage *ts) {
+    if (ts->allocator.proc) return ts->allocator;
+    return {heap_allocator, null};
+}
 
-        IMAGEHLP_LINEW64 line64 = {};
-        line64.SizeOfStruct = size_of(IMAGEHLP_LINEW64);
+static bool temporary_storage_push_block(Temporary_Storage *ts, s64 nbytes) {
+    Temporary_Storage_Block *block = null;
 
-        u16 frames = CaptureStackBackTrace(0, MAX_STACK_FRAMES, stack, null);
-        if (frames > 0) {
-            printf("Caller stack:\n");
-            for (u16 index = 0; index < frames; ++index) {
-                DWORD64 dw_displacement64;
-                BOOL ok = SymFromAddr(process, (DWORD64)(stack[index]), &dw_displacement64, symbol_info);
-                if (!ok) continue;
+    for (Temporary_Storage_Block **it = &ts->unused_blocks; *it; it = &(*it)->previous) {
+        if ((*it)->capacity >= nbytes) {
+            block = *it;
+            *it = block->previous;
+            break;
+        }
+    }
 
-                s64 call_line;
-                s64 stack_line;
+    if (!block) {
+        // Grow geometrically so spikes that creep up keep hitting recycled blocks.
+        s64 capacity = Max(2 * ts->size, TEMPORARY_STORAGE_SIZE_DEFAULT);
+        while (capacity < nbytes) capacity *= 2;
 
-                DWORD64 call_address = (DWORD64)(stack[index]);  // Caller location.
-                DWORD64 stack_address = symbol_info->Address;    // Procedure location.
+        Allocator a = temporary_storage_block_allocator(ts);
+        block = (Temporary_Storage_Block *)allocator_call(a, ALLOCATOR_ALLOCATE_UNINITIALIZED, size_of(Temporary_Storage_Block) + capacity);
+        if (!block) return false;
 
-                DWORD dw_displacement;
-                ok = SymGetLineFromAddrW64(process, call_address, &dw_displacement, &line64);
-                if (!ok) continue;
+        block->capacity = capacity;
+        Log(LOG_VERBOSE, "Temporary_Storage", "Chaining a new block.");
+    }
 
-                call_line = line64.LineNumber;
+    block->previous       = ts->current_block;
+    block->previous_data  = ts->data;
+    block->previous_size  = ts->size;
+    block->previous_start = ts->block_start;
 
-                ok = SymGetLineFromAddrW64(process, stack_address, &dw_displacement, &line64);
-                if (!ok) continue;
+    ts->current_block = block;
+    ts->data          = (u8 *)(block + 1);
+    ts->size          = block->capacity;
+    ts->block_start   = ts->occupied;
+    return true;
+}
 
-                stack_line = line64.LineNumber;
+TINYRT_EXTERN void temporary_storage_pop_blocks(Temporary_Storage *ts, s64 mark) {
+    while (ts->current_block && (mark < ts->block_start)) {
+        Temporary_Storage_Block *block = ts->current_block;
 
-                printf("0x%016llX: %s(%lld) Line %lld\n", stack_address, symbol_info->Name, stack_line, call_line);
-            }
-        }
-    } else {
-        write_string("[backtrace] Error: Failed to SymInitialize.\n", true);
+        ts->current_block = block->previous;
+        ts->data          = block->previous_data;
+        ts->size          = block->previous_size;
+        ts->block_start   = block->previous_start;
+
+        block->previous   = ts->unused_blocks;
+        ts->unused_blocks = block;
     }
 }
-*/
 
-TINYRT_EXTERN char *get_stacktrace(void) {
-    char *result = null;
-    HANDLE process = GetCurrentProcess();
- 
-    static BOOL initted = false;
-    if (!initted) {
-        initted = SymInitialize(process, null, TRUE);
-        SymSetOptions(SYMOPT_LOAD_LINES);
+static void *temporary_storage_get(Temporary_Storage *ts, s64 nbytes, s64 alignment) {
+    if (!ts->data) {
+        if (!temporary_storage_init_backing(ts)) return null;
     }
 
-    if (initted == TRUE) {
-        // Windows Server 2003 and Windows XP: The sum of the FramesToSkip and FramesToCapture parameters must be less than 63.
-        const int MAX_STACK_FRAMES = 63;
-        void *stack[MAX_STACK_FRAMES];
-
-        const int MAX_SYMBOL_NAME = 255;
-        u8 buf[size_of(SYMBOL_INFO) + (MAX_SYMBOL_NAME+1)];
-
-        SYMBOL_INFO *symbol_info = (SYMBOL_INFO *)buf;
-        symbol_info->MaxNameLen = MAX_SYMBOL_NAME;
-        symbol_info->SizeOfStruct = size_of(SYMBOL_INFO);
-
-        IMAGEHLP_LINEW64 line64 = {};
-        line64.SizeOfStruct = size_of(IMAGEHLP_LINEW64);
-
-        u16 frames = CaptureStackBackTrace(0, MAX_STACK_FRAMES, stack, null);
-        if (frames > 0) {
-            result = tprint("Caller stack:\n");
-            for (u16 index = 0; index < frames; ++index) {
-                DWORD64 dw_displacement64;
-                BOOL ok = SymFromAddr(process, (DWORD64)(stack[index]), &dw_displacement64, symbol_info);
-                if (!ok) continue;
-
-                s64 call_line;
-                s64 stack_line;
-
-                DWORD64 call_address = (DWORD64)(stack[index]);  // Caller location.
-                DWORD64 stack_address = symbol_info->Address;    // Procedure location.
-
-                DWORD dw_displacement;
-                ok = SymGetLineFromAddrW64(process, call_address, &dw_displacement, &line64);
-                if (!ok) continue;
+    s64 offset  = ts->occupied - ts->block_start;
+    s64 padding = (s64)align_forward_offset((umm)(ts->data + offset), (umm)alignment);
 
-                call_line = line64.LineNumber;
+    if (padding + nbytes > (ts->size - offset)) {
+        // Chained blocks sit past the reservation, only commit while still in it.
+        s64 needed = ts->occupied + padding + nbytes;
 
-                ok = SymGetLineFromAddrW64(process, stack_address, &dw_displacement, &line64);
-                if (!ok) continue;
+        if (ts->reserved && !ts->current_block && (needed <= ts->reserved)) {
+            s64 new_size = Min(align_forward(needed, TEMPORARY_STORAGE_COMMIT_SIZE), ts->reserved);
+            if (!os_commit_memory(ts->data + ts->size, new_size - ts->size)) return null;
 
-                stack_line = line64.LineNumber;
+            ts->size = new_size;
+        } else {
+            if (!temporary_storage_push_block(ts, nbytes + alignment)) return null;
 
-                char *s = tprint("%s0x%016llX: %s(%lld) Line %lld\n", result, stack_address, symbol_info->Name, stack_line, call_line);
-                result = s;
-            }
+            offset  = 0;
+            padding = (s64)align_forward_offset((umm)ts->data, (umm)alignment);
         }
-    } else {
-        write_string("[backtrace] Error: Failed to SymInitialize.\n", true);
     }
 
+    void *result = ts->data + offset + padding;
+    ts->last_allocation = ts->occupied + padding;
+    ts->occupied += padding + nbytes;
+
+    if (ts->occupied > ts->high_water_mark) ts->high_water_mark = ts->occupied;
     return result;
 }
-#endif  // ENABLE_ASSERTS
-
-
-
-
-TINYRT_EXTERN void *heap_allocator(Allocator_Mode mode, s64 size, s64 old_size, void *old_memory, void *allocator_data) {
-    UNUSED(allocator_data);
-
-    switch (mode) {
-        case ALLOCATOR_ALLOCATE:
-            return HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, (umm)size);
 
-        case ALLOCATOR_RESIZE: {
-            // Allocate, copy, free.
-
-            void *result = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, (umm)size);
-            if (result == null) return null;
+// Grows or shrinks the newest allocation by moving occupied, false if it does not fit.
+static bool temporary_storage_resize_last(Temporary_Storage *ts, void *memory, s64 nbytes) {
+    s64 offset = ts->last_allocation - ts->block_start;
+    if ((ts->last_allocation < ts->block_start) || (memory != ts->data + offset)) return false;
 
-            if (old_memory && (old_size > 0)) {
-                memcpy(result, old_memory, (umm)old_size);
-                HeapFree(GetProcessHeap(), 0, old_memory);
-            }
+    if (offset + nbytes > ts->size) {
+        if (!ts->reserved || ts->current_block || (ts->last_allocation + nbytes > ts->reserved)) return false;
 
-            return result;
-        } break;
+        s64 new_size = Min(align_forward(ts->last_allocation + nbytes, TEMPORARY_STORAGE_COMMIT_SIZE), ts->reserved);
+        if (!os_commit_memory(ts->data + ts->size, new_size - ts->size)) return false;
 
-        case ALLOCATOR_FREE: {
-            HeapFree(GetProcessHeap(), 0, old_memory);
-            return null;
-        } break;
+        ts->size = new_size;
+    }
 
-        case ALLOCATOR_FREE_ALL: {
-            // Not supported.
-            assert(!"Not supported");
-            return null;
-        } break;
+    ts->occupied = ts->last_allocation + nbytes;
 
-        default: {
-            assert(false);
-            return null;
-        } break;
-    }
+    if (ts->occupied > ts->high_water_mark) ts->high_water_mark = ts->occupied;
+    return true;
 }
 
-#endif  // OS_WINDOWS
+TINYRT_EXTERN void temporary_storage_decommit(Temporary_Storage *ts, s64 keep_committed) {
+    if (!ts->reserved || ts->current_block) return;
 
+    keep_committed = align_forward(Max(keep_committed, ts->occupied), TEMPORARY_STORAGE_COMMIT_SIZE);
+    if (keep_committed >= ts->size) return;
 
+    os_decommit_memory(ts->data + keep_committed, ts->size - keep_committed);
+    ts->size = keep_committed;
+}
 
 TINYRT_EXTERN ALLOCATOR_PROC(temporary_storage_proc) {
     Temporary_Storage *ts = (Temporary_Storage *)allocator_data;
-
-    if (!ts->allocator.proc) {
-        ts->allocator.proc = heap_allocator;
-        ts->allocator.data = null;
-    }
+    if (!ts) ts = &temporary_storage;
 
     s64 nbytes = size;
     s64 alignment = 8;
@@ -1505,47 +2468,21 @@ TINYRT_EXTERN ALLOCATOR_PROC(temporary_storage_proc) {
     nbytes += extra;
 
     switch (mode) {
-        case ALLOCATOR_ALLOCATE: {
-            if (!ts->data) {
-                ts->data = (u8 *)ts->allocator.proc(ALLOCATOR_ALLOCATE, ts->size, 0, null, ts->allocator.data);
-                if (!ts->data) return null;
-            }
-
-#if GENERAL_DEBUG
-            if (nbytes > (ts->size - ts->occupied)) {
-                ts->high_water_mark += nbytes;
-                Log(LOG_MINIMAL, "Temporary_Storage", "Attempting to allocate from the heap, highest water mark: %lld\n", ts->high_water_mark);
-                return heap_allocator(ALLOCATOR_ALLOCATE, nbytes, 0, null, null);
-            }
-#else
-            // @Cleanup:
-            assert(nbytes <= (ts->size - ts->occupied));
-#endif
+        case ALLOCATOR_ALLOCATE:
+        case ALLOCATOR_ALLOCATE_UNINITIALIZED:
+            return temporary_storage_get(ts, nbytes, alignment);
 
-            void *result = ts->data + ts->occupied;
-            ts->occupied += nbytes;
-            return result;
-        } break;
+        case ALLOCATOR_ALLOCATE_ALIGNED:
+            assert(is_power_of_2(old_size));
+            return temporary_storage_get(ts, nbytes, Max(old_size, alignment));
 
         case ALLOCATOR_RESIZE: {
-            // Bump allocators do not resize so we allocate
-            // a new chunk of memory using the new size.
-
-
-            // @Cutnpaste: from ALLOCATOR_ALLOCATE.
-#if GENERAL_DEBUG
-            if (nbytes > (ts->size - ts->occupied)) {
-                ts->high_water_mark += nbytes;
-                Log(LOG_MINIMAL, "Temporary_Storage", "Attempting to allocate from the heap, highest water mark: %lld\n", ts->high_water_mark);
-                return heap_allocator(ALLOCATOR_ALLOCATE, nbytes, 0, null, null);
-            }
-#else
-            // @Cleanup:
-            assert(nbytes <= (ts->size - ts->occupied));
-#endif
+            // The newest allocation grows in place, anything else
+            // gets a new chunk of memory using the new size.
+            if (old_memory && temporary_storage_resize_last(ts, old_memory, nbytes)) return old_memory;
 
-            void *result = ts->data + ts->occupied;
-            ts->occupied += nbytes;
+            void *result = temporary_storage_get(ts, nbytes, alignment);
+            if (!result) return null;
 
             if (old_memory && (old_size > 0)) {
                 memcpy(result, old_memory, Min(old_size, nbytes));
@@ -1554,16 +2491,44 @@ TINYRT_EXTERN ALLOCATOR_PROC(temporary_storage_proc) {
             return result;
         } break;
 
-        case ALLOCATOR_FREE:
-            // Not supported.
-            assert(false);
+        case ALLOCATOR_FREE: {
+            // Only the newest allocation gives its memory back.
+            if (old_memory && temporary_storage_resize_last(ts, old_memory, 0)) {
+                ts->last_allocation = -1;
+            }
+
             return null;
+        } break;
+
+        case ALLOCATOR_CAPS:
+            return (void *)(umm)(ALLOCATOR_CAPS_FREE_ALL | ALLOCATOR_CAPS_RESIZE_IN_PLACE | ALLOCATOR_CAPS_USABLE_SIZE);
+
+        case ALLOCATOR_USABLE_SIZE:
+            // Every allocation is padded to the alignment.
+            return (void *)(umm)nbytes;
 
         case ALLOCATOR_FREE_ALL: {
-            ts->allocator.proc(ALLOCATOR_FREE, 0, 0, ts->data, ts->allocator.data);
+            temporary_storage_pop_blocks(ts, -1);
+
+            if (ts->reserved) {
+                os_release_memory(ts->data, ts->reserved);
+            } else if (ts->data) {
+                ts->allocator.proc(ALLOCATOR_FREE, 0, 0, ts->data, ts->allocator.data);
+            }
+
+            Allocator a = temporary_storage_block_allocator(ts);
+            while (ts->unused_blocks) {
+                Temporary_Storage_Block *block = ts->unused_blocks;
+                ts->unused_blocks = block->previous;
+                a.proc(ALLOCATOR_FREE, 0, 0, block, a.data);
+            }
+
             ts->data = null;
-            ts->size = 0;
+            ts->size = TEMPORARY_STORAGE_SIZE_DEFAULT;
+            ts->reserved = 0;
             ts->occupied = 0;
+            ts->block_start = 0;
+            ts->last_allocation = -1;
             ts->high_water_mark = 0;
             return null;
         } break;
@@ -1574,6 +2539,33 @@ TINYRT_EXTERN ALLOCATOR_PROC(temporary_storage_proc) {
     }
 }
 
+static Allocator_Proc *volatile allocator_extended_procs[ALLOCATOR_EXTENDED_PROC_COUNT];
+static volatile s64 allocator_extended_proc_count = 0;
+
+TINYRT_EXTERN bool allocator_declare_extended_modes(Allocator_Proc *proc) {
+    if (allocator_knows_extended_modes(proc)) return true;
+
+    s64 index = atomic_fetch_add(&allocator_extended_proc_count, 1);
+    if (index >= ALLOCATOR_EXTENDED_PROC_COUNT) {
+        assert(!"Too many allocator procs declare the extended modes, raise ALLOCATOR_EXTENDED_PROC_COUNT.");
+        return false;
+    }
+
+    atomic_store_pointer((void *volatile *)&allocator_extended_procs[index], (void *)proc);
+    return true;
+}
+
+TINYRT_EXTERN bool allocator_knows_extended_modes(Allocator_Proc *proc) {
+    if ((proc == heap_allocator) || (proc == temporary_storage_proc)) return true;
+
+    s64 count = Min(atomic_load(&allocator_extended_proc_count), ALLOCATOR_EXTENDED_PROC_COUNT);
+    for (s64 index = 0; index < count; ++index) {
+        if (atomic_load_pointer((void *volatile *)&allocator_extended_procs[index]) == (void *)proc) return true;
+    }
+
+    return false;
+}
+
 
 
 static s64 get_partition_index_for_qsort(u8 *data, s64 low, s64 high, s64 stride, s64 (*qsort_compare)(void *, void *)) {
@@ -1623,6 +2615,7 @@ void quick_sort(void *data, s64 count, s64 stride, s64 (*qsort_compare)(void *,
 void quick_sort_it(void *data, s64 count, s64 stride, s64 (*qsort_compare)(void *, void *)) {
     if (count < 2) return;
 
+    s64 mark = get_temporary_storage_mark();
     s64 *qsort_stack = NewArray(s64, count * 2, temporary_allocator);
 
     // Push.
@@ -1649,6 +2642,8 @@ void quick_sort_it(void *data, s64 count, s64 stride, s64 (*qsort_compare)(void
             qsort_stack[++top] = high;
         }
     }
+
+    set_temporary_storage_mark(mark);
 }
 
 void radix_sort(u32 *data, s64 count) {
@@ -1662,6 +2657,7 @@ void radix_sort(u32 *data, s64 count) {
     }
 
 
+    s64 mark = get_temporary_storage_mark();
     u32 *output_array = NewArray(u32, count, temporary_allocator);
 
     for (u32 exp = 1; (biggest_entry / exp) > 0; exp *= 10) {
@@ -1687,6 +2683,8 @@ void radix_sort(u32 *data, s64 count) {
             data[index] = output_array[index];
         }
     }
+
+    set_temporary_storage_mark(mark);
 }
 
 #endif  // GENERAL_IMPLEMENTATION
@@ -0,0 +1,310 @@
+#ifndef GENERAL_NUMA_INCLUDE_H
+#define GENERAL_NUMA_INCLUDE_H
+/*
+
+    NUMA block allocator.
+
+    Maps blocks straight from the OS and binds them to a NUMA node before
+    anything touches them, meant to be used as Pool::block_allocator so a
+    pool filled by a worker lives on the worker's node. On Linux binding
+    goes through the mbind and get_mempolicy system calls, there is no
+    libnuma dependency.
+
+    The binding is a preference, a full node spills over to the others
+    instead of failing. Machines with a single node, kernels without
+    NUMA support and containers that refuse the calls still get working
+    blocks, they are just counted in unbound_blocks. Other platforms
+    forward everything to the fallback allocator.
+
+    Blocks are mapped with a header in front, small requests waste most
+    of a page, so keep this for pool sized blocks.
+
+        Numa_Block_Allocator numa;  // Binds to the node of the calling thread.
+
+        Pool pool;
+        pool_init(&pool);
+        set_allocators(&pool, {numa_block_allocator_proc, &numa});
+
+
+    Numa_Pool_Registry keeps a Concurrent_Pool per node, workers pick the
+    one of the node they run on. The blocks of each pool are bound to its
+    node, whichever thread happens to grow it.
+
+        Numa_Pool_Registry registry;
+        numa_pool_registry_init(&registry);
+
+        Concurrent_Pool *pool = numa_pool_for_current_node(&registry);
+        void *memory = concurrent_pool_get(pool, 100);
+
+
+    To include numa implementation as cpp file use:
+
+    #define NUMA_IMPLEMENTATION
+    #include "numa.h"
+
+*/
+
+#include "general.h"
+#include "pool.h"
+
+
+const s64 NUMA_MAX_NODES         = 64;
+const s64 NUMA_BLOCK_HEADER_SIZE = 64;  // Keeps blocks cache line aligned.
+
+typedef struct Numa_Block_Allocator {
+    s64 node = -1;  // -1 binds every block to the node of the thread asking for it.
+
+    volatile s64 bound_blocks   = 0;
+    volatile s64 unbound_blocks = 0;  // The OS would not bind them, they work all the same.
+
+    Allocator fallback = {heap_allocator, null};  // Only used on platforms other than Linux.
+} Numa_Block_Allocator;
+
+typedef struct Numa_Pool_Registry {
+    s64 node_count = 0;
+
+    Numa_Block_Allocator block_allocators[NUMA_MAX_NODES];
+    Concurrent_Pool pools[NUMA_MAX_NODES];
+} Numa_Pool_Registry;
+
+TINYRT_EXTERN s64 numa_node_count(void);
+TINYRT_EXTERN s64 numa_current_node(void);
+TINYRT_EXTERN s64 numa_node_of(void *memory);  // -1 if the OS can not tell.
+TINYRT_EXTERN bool numa_bind_memory(void *memory, s64 size, s64 node);
+
+TINYRT_EXTERN ALLOCATOR_PROC(numa_block_allocator_proc);
+
+void numa_pool_registry_init(Numa_Pool_Registry *registry, s64 block_size = POOL_BUCKET_SIZE_DEFAULT);
+
+TINYRT_EXTERN Concurrent_Pool *numa_pool_for_node(Numa_Pool_Registry *registry, s64 node);
+TINYRT_EXTERN Concurrent_Pool *numa_pool_for_current_node(Numa_Pool_Registry *registry);
+TINYRT_EXTERN void numa_pool_registry_reset(Numa_Pool_Registry *registry);
+TINYRT_EXTERN void numa_pool_registry_release(Numa_Pool_Registry *registry);
+
+#endif  // GENERAL_NUMA_INCLUDE_H
+
+
+#if defined(NUMA_IMPLEMENTATION) && !defined(NUMA_IMPLEMENTATION_INCLUDED)
+#define NUMA_IMPLEMENTATION_INCLUDED
+
+#if OS_LINUX
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+const s64 NUMA_MASK_BITS = 1024;  // get_mempolicy wants room for every node the kernel knows.
+
+TINYRT_EXTERN s64 numa_node_count(void) {
+    static s64 node_count = 0;
+    if (node_count) return node_count;
+
+    u64 mask[NUMA_MASK_BITS / 64] = {};
+
+    s64 result = 1;
+    if (syscall(SYS_get_mempolicy, null, mask, NUMA_MASK_BITS, null, MPOL_F_MEMS_ALLOWED) == 0) {
+        for (s64 node = 0; node < NUMA_MAX_NODES; ++node) {
+            if (mask[node / 64] & (1ull << (node % 64))) result = node + 1;
+        }
+    }
+
+    node_count = result;
+    return node_count;
+}
+
+TINYRT_EXTERN s64 numa_current_node(void) {
+    unsigned cpu  = 0;
+    unsigned node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, null) != 0) return 0;
+
+    return (s64)node;
+}
+
+TINYRT_EXTERN s64 numa_node_of(void *memory) {
+    int node = -1;
+    if (syscall(SYS_get_mempolicy, &node, null, 0, memory, MPOL_F_NODE | MPOL_F_ADDR) != 0) return -1;
+
+    return (s64)node;
+}
+
+// memory has to start on a page. Pages that were touched already stay where they are.
+TINYRT_EXTERN bool numa_bind_memory(void *memory, s64 size, s64 node) {
+    if ((node < 0) || (node >= NUMA_MAX_NODES)) return false;
+
+    u64 mask = 1ull << node;
+
+    // The kernel drops the last bit of maxnode, so ask for one more.
+    return syscall(SYS_mbind, memory, (unsigned long)size, MPOL_PREFERRED, &mask, 64 + 1, 0) == 0;
+}
+
+typedef struct Numa_Block_Header {
+    s64 mapped_size;
+    s64 offset;  // Bytes from the start of the mapping to this header.
+    s64 node;
+    s64 padding[5];
+} Numa_Block_Header;
+
+static void *numa_map_block(Numa_Block_Allocator *numa, s64 size, s64 alignment) {
+    if (alignment < NUMA_BLOCK_HEADER_SIZE) alignment = NUMA_BLOCK_HEADER_SIZE;
+
+    s64 mapped_size = align_forward(size + alignment, os_get_page_size());
+
+    u8 *memory = (u8 *)mmap(null, (size_t)mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == (u8 *)MAP_FAILED) return null;
+
+    // Bind before the header write faults in the first page.
+    s64 node = (numa->node >= 0) ? numa->node : numa_current_node();
+    if (numa_bind_memory(memory, mapped_size, node)) {
+        atomic_fetch_add(&numa->bound_blocks, 1);
+    } else {
+        atomic_fetch_add(&numa->unbound_blocks, 1);
+    }
+
+    u8 *result = align_forward_pointer(memory + NUMA_BLOCK_HEADER_SIZE, alignment);
+
+    Numa_Block_Header *header = (Numa_Block_Header *)result - 1;
+    header->mapped_size = mapped_size;
+    header->offset      = (u8 *)header - memory;
+    header->node        = node;
+    return result;
+}
+
+static void numa_unmap_block(void *block) {
+    Numa_Block_Header *header = (Numa_Block_Header *)block - 1;
+    munmap((u8 *)header - header->offset, (size_t)header->mapped_size);
+}
+
+static inline s64 numa_block_capacity(void *block) {
+    Numa_Block_Header *header = (Numa_Block_Header *)block - 1;
+    return header->mapped_size - header->offset - NUMA_BLOCK_HEADER_SIZE;
+}
+
+TINYRT_EXTERN ALLOCATOR_PROC(numa_block_allocator_proc) {
+    Numa_Block_Allocator *numa = (Numa_Block_Allocator *)allocator_data;
+    assert(numa != null);
+
+    switch (mode) {
+        case ALLOCATOR_ALLOCATE:
+        case ALLOCATOR_ALLOCATE_UNINITIALIZED:
+            // Fresh pages come zeroed from the kernel.
+            return numa_map_block(numa, size, 0);
+
+        case ALLOCATOR_ALLOCATE_ALIGNED:
+            assert(is_power_of_2(old_size));
+            return numa_map_block(numa, size, old_size);
+
+        case ALLOCATOR_RESIZE: {
+            if (!old_memory) return numa_map_block(numa, size, 0);
+
+            s64 capacity = numa_block_capacity(old_memory);
+            if (size <= capacity) {
+                if (old_size < size) memory_zero((u8 *)old_memory + old_size, (umm)(size - old_size));
+                return old_memory;
+            }
+
+            // The new block lands on the node asking for it, like any other.
+            void *result = numa_map_block(numa, size, 0);
+            if (!result) return null;
+
+            memcpy(result, old_memory, (umm)Min(old_size, capacity));
+            numa_unmap_block(old_memory);
+            return result;
+        } break;
+
+        case ALLOCATOR_FREE:
+            if (old_memory) numa_unmap_block(old_memory);
+            return null;
+
+        case ALLOCATOR_FREE_ALL:
+            // Not supported.
+            assert(!"Not supported");
+            return null;
+
+        case ALLOCATOR_CAPS:
+            return (void *)(umm)(ALLOCATOR_CAPS_FREE | ALLOCATOR_CAPS_RESIZE_IN_PLACE | ALLOCATOR_CAPS_USABLE_SIZE | ALLOCATOR_CAPS_ZEROED);
+
+        case ALLOCATOR_USABLE_SIZE:
+            if (!old_memory) return null;
+            return (void *)(umm)numa_block_capacity(old_memory);
+
+        default:
+            assert(false);
+            return null;
+    }
+}
+
+#else
+
+TINYRT_EXTERN s64 numa_node_count(void) {
+    return 1;
+}
+
+TINYRT_EXTERN s64 numa_current_node(void) {
+    return 0;
+}
+
+TINYRT_EXTERN s64 numa_node_of(void *memory) {
+    UNUSED(memory);
+    return -1;
+}
+
+TINYRT_EXTERN bool numa_bind_memory(void *memory, s64 size, s64 node) {
+    UNUSED(memory);
+    UNUSED(size);
+    UNUSED(node);
+    return false;
+}
+
+TINYRT_EXTERN ALLOCATOR_PROC(numa_block_allocator_proc) {
+    Numa_Block_Allocator *numa = (Numa_Block_Allocator *)allocator_data;
+    assert(numa != null);
+
+    Allocator a = numa->fallback;
+    assert(a.proc != null);
+    return allocator_call(a, mode, size, old_size, old_memory);
+}
+
+#endif  // OS_LINUX
+
+// Answers the modes past ALLOCATOR_ALLOCATE_ALIGNED, see allocator_call.
+static bool numa_block_allocator_declared = allocator_declare_extended_modes(numa_block_allocator_proc);
+
+void numa_pool_registry_init(Numa_Pool_Registry *registry, s64 block_size) {
+    registry->node_count = numa_node_count();
+
+    for (s64 node = 0; node < registry->node_count; ++node) {
+        Numa_Block_Allocator *numa = &registry->block_allocators[node];
+        numa->node           = node;
+        numa->bound_blocks   = 0;
+        numa->unbound_blocks = 0;
+
+        concurrent_pool_init(&registry->pools[node], block_size, POOL_ALIGNMENT_DEFAULT, {numa_block_allocator_proc, numa});
+    }
+}
+
+// Nodes past the ones the registry knows about share the pool of node 0.
+TINYRT_EXTERN Concurrent_Pool *numa_pool_for_node(Numa_Pool_Registry *registry, s64 node) {
+    assert(registry->node_count > 0);
+
+    if ((node < 0) || (node >= registry->node_count)) node = 0;
+    return &registry->pools[node];
+}
+
+TINYRT_EXTERN Concurrent_Pool *numa_pool_for_current_node(Numa_Pool_Registry *registry) {
+    return numa_pool_for_node(registry, numa_current_node());
+}
+
+// Like concurrent_pool_reset, no thread may be allocating from any of the pools.
+TINYRT_EXTERN void numa_pool_registry_reset(Numa_Pool_Registry *registry) {
+    for (s64 node = 0; node < registry->node_count; ++node) {
+        concurrent_pool_reset(&registry->pools[node]);
+    }
+}
+
+TINYRT_EXTERN void numa_pool_registry_release(Numa_Pool_Registry *registry) {
+    for (s64 node = 0; node < registry->node_count; ++node) {
+        concurrent_pool_release(&registry->pools[node]);
+    }
+}
+
+#endif  // NUMA_IMPLEMENTATION
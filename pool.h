@@ -30,13 +30,31 @@ typedef struct Pool {
     u8 *current_pos      = null;
     s64 bytes_left       = 0;
 
+    u8 *last_allocation  = null;  // Newest allocation of the current memblock.
+
     Array<u8 *> used_memblocks;
     Array<u8 *> unused_memblocks;
     Array<u8 *> out_of_band_allocations;
 
+    // Retention policy for unused_memblocks, applied by pool_reset.
+    s64 retain_memblocks_max = -1;     // -1 keeps every block.
+    s64 retain_decay_resets  = 0;      // Spare blocks fade out over this many resets, 0 keeps them.
+    bool purge_retained      = false;  // Blocks idle for a whole reset cycle give their pages back.
+
+    s64 retain_target    = 0;  // Decaying peak of the blocks in use at reset.
+    s64 purged_memblocks = 0;  // Front of unused_memblocks that is already purged.
+    s64 released_bytes   = 0;  // Freed back to block_allocator so far.
+
     Allocator block_allocator = {heap_allocator, null};
 } Pool;
 
+typedef struct Pool_Stats {
+    s64 used_bytes;      // Memblocks in use since the last reset.
+    s64 retained_bytes;  // Memblocks kept on unused_memblocks.
+    s64 purged_bytes;    // Part of retained_bytes whose pages went back to the OS.
+    s64 released_bytes;  // Freed back to block_allocator so far.
+} Pool_Stats;
+
 void set_allocators(Pool *pool, 
                     Allocator block_allocator = {heap_allocator, null},
                     Allocator array_allocator = {heap_allocator, null});
@@ -50,20 +68,425 @@ inline void pool_init(Pool *pool,
     pool->current_memblock = null;
     pool->current_pos      = null;
     pool->bytes_left       = 0;
+    pool->last_allocation  = null;
+
+    pool->retain_target    = 0;
+    pool->purged_memblocks = 0;
+    pool->released_bytes   = 0;
 
     set_allocators(pool, {heap_allocator, null}, {heap_allocator, null});
 }
 
 TINYRT_EXTERN void *pool_get(Pool *pool, s64 nbytes);
+TINYRT_EXTERN void *pool_get_aligned(Pool *pool, s64 nbytes, s64 alignment);
 TINYRT_EXTERN void pool_release(Pool *pool);
 TINYRT_EXTERN void pool_reset(Pool *pool);
+TINYRT_EXTERN Pool_Stats pool_get_stats(Pool *pool);
 
 TINYRT_EXTERN ALLOCATOR_PROC(pool_allocator_proc);
 
+// Calls the typed proc an Object_Pool starts with, one proc for every T.
+TINYRT_EXTERN ALLOCATOR_PROC(object_pool_allocator_dispatch);
+
+
+/*
+
+    Typed object pool.
+
+    Fixed size slots for T carved out of a Pool, freed slots go on an
+    intrusive free list, so getting and putting back an object is O(1)
+    and freed slots are reused before the pool grows.
+
+    object_pool_allocator lets New or an Array draw from the pool.
+    Requests that do not fit a slot go to the block allocator and are
+    remembered in a hash set, freeing through the allocator looks them
+    up first, that stays O(1).
+
+*/
+
+// Open addressing set of pointers, removal shifts the cluster back so there are no tombstones.
+typedef struct Object_Pool_Large_Set {
+    u8 **pointers = null;
+    s64 capacity  = 0;
+    s64 count     = 0;
+} Object_Pool_Large_Set;
+
+template<typename T>
+ALLOCATOR_PROC(object_pool_allocator_proc);
+
+template<typename T>
+struct Object_Pool {
+    Allocator_Proc *allocator_proc = object_pool_allocator_proc<T>;  // Has to come first, see object_pool_allocator_dispatch.
+
+    Pool pool;
+
+    u8 *free_list  = null;  // Next pointer lives in the freed slot.
+    s64 live_count = 0;
+
+    Object_Pool_Large_Set large_allocations;  // Allocator requests bigger than a slot.
+};
+
+inline s64 object_pool_large_slot(void *pointer, s64 capacity) {
+    return (s64)(((u64)(umm)pointer * 11400714819323198485ull) >> 32) & (capacity - 1);
+}
+
+inline void object_pool_large_insert(Object_Pool_Large_Set *set, u8 *pointer) {
+    if ((set->count + 1) * 2 > set->capacity) {
+        // Keep the load factor under one half.
+        s64 old_capacity = set->capacity;
+        u8 **old_pointers = set->pointers;
+
+        s64 new_capacity = old_capacity ? old_capacity * 2 : 64;
+
+        set->pointers = (u8 **)heap_alloc(new_capacity * size_of(u8 *));
+        set->capacity = new_capacity;
+        assert(set->pointers != null);
+
+        for (s64 index = 0; index < old_capacity; ++index) {
+            if (!old_pointers[index]) continue;
+
+            s64 slot = object_pool_large_slot(old_pointers[index], new_capacity);
+            while (set->pointers[slot]) slot = (slot + 1) & (new_capacity - 1);
+            set->pointers[slot] = old_pointers[index];
+        }
+
+        if (old_pointers) heap_free(old_pointers);
+    }
+
+    s64 slot = object_pool_large_slot(pointer, set->capacity);
+    while (set->pointers[slot]) slot = (slot + 1) & (set->capacity - 1);
+
+    set->pointers[slot] = pointer;
+    set->count += 1;
+}
+
+// False if pointer was not in the set.
+inline bool object_pool_large_remove(Object_Pool_Large_Set *set, void *pointer) {
+    if (!set->count) return false;
+
+    s64 mask = set->capacity - 1;
+    s64 slot = object_pool_large_slot(pointer, set->capacity);
+
+    while (set->pointers[slot] != pointer) {
+        if (!set->pointers[slot]) return false;
+        slot = (slot + 1) & mask;
+    }
+
+    s64 hole = slot;
+    s64 next = (slot + 1) & mask;
+    while (set->pointers[next]) {
+        s64 home = object_pool_large_slot(set->pointers[next], set->capacity);
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            set->pointers[hole] = set->pointers[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+
+    set->pointers[hole] = null;
+    set->count -= 1;
+    return true;
+}
+
+template<typename T>
+constexpr s64 object_pool_slot_alignment(void) {
+    return (alignof(T) > size_of(u8 *)) ? (s64)alignof(T) : (s64)size_of(u8 *);
+}
+
+template<typename T>
+constexpr s64 object_pool_slot_size(void) {
+    return align_forward((s64)size_of(T), object_pool_slot_alignment<T>());
+}
+
+template<typename T>
+void object_pool_init(Object_Pool<T> *op,
+                      s64 block_size = POOL_BUCKET_SIZE_DEFAULT,
+                      Allocator block_allocator = {heap_allocator, null}) {
+    op->allocator_proc = object_pool_allocator_proc<T>;
+
+    pool_init(&op->pool, block_size, POOL_ALIGNMENT_DEFAULT);
+    set_allocators(&op->pool, block_allocator);
+
+    op->free_list  = null;
+    op->live_count = 0;
+
+    Object_Pool_Large_Set *set = &op->large_allocations;
+    if (set->pointers) memory_zero(set->pointers, (umm)(set->capacity * size_of(u8 *)));
+    set->count = 0;
+}
+
+// The object comes back zeroed, like from New.
+template<typename T>
+T *object_pool_get(Object_Pool<T> *op) {
+    u8 *result = op->free_list;
+
+    if (result) {
+        op->free_list = *(u8 **)result;
+        memory_zero(result, size_of(T));
+    } else {
+        result = (u8 *)pool_get_aligned(&op->pool, object_pool_slot_size<T>(), object_pool_slot_alignment<T>());
+        if (!result) return null;
+
+        // Pool memory gets reused across resets, so it can be dirty.
+        memory_zero(result, size_of(T));
+    }
+
+    op->live_count += 1;
+    return (T *)result;
+}
+
+template<typename T>
+void object_pool_put(Object_Pool<T> *op, T *object) {
+    if (!object) return;
+    assert(op->live_count > 0);
+
+    *(u8 **)object = op->free_list;
+    op->free_list  = (u8 *)object;
+    op->live_count -= 1;
+}
+
+template<typename T>
+void object_pool_free_large_allocations(Object_Pool<T> *op) {
+    Allocator a = op->pool.block_allocator;
+    Object_Pool_Large_Set *set = &op->large_allocations;
+
+    if (!set->count) return;
+
+    for (s64 index = 0; index < set->capacity; ++index) {
+        if (set->pointers[index]) a.proc(ALLOCATOR_FREE, 0, 0, set->pointers[index], a.data);
+    }
+
+    memory_zero(set->pointers, (umm)(set->capacity * size_of(u8 *)));
+    set->count = 0;
+}
+
+// Every object goes back at once, the blocks are kept for reuse.
+template<typename T>
+void object_pool_reset(Object_Pool<T> *op) {
+    pool_reset(&op->pool);
+    object_pool_free_large_allocations(op);
+
+    op->free_list  = null;
+    op->live_count = 0;
+}
+
+template<typename T>
+void object_pool_release(Object_Pool<T> *op) {
+    pool_release(&op->pool);
+    object_pool_free_large_allocations(op);
+
+    if (op->large_allocations.pointers) heap_free(op->large_allocations.pointers);
+    op->large_allocations.pointers = null;
+    op->large_allocations.capacity = 0;
+
+    array_free(&op->pool.used_memblocks);
+    array_free(&op->pool.unused_memblocks);
+    array_free(&op->pool.out_of_band_allocations);
+
+    op->free_list  = null;
+    op->live_count = 0;
+}
+
+// Takes memory out of large_allocations, false if it is a slot.
+template<typename T>
+bool object_pool_remove_large_allocation(Object_Pool<T> *op, void *memory) {
+    return object_pool_large_remove(&op->large_allocations, memory);
+}
+
+template<typename T>
+ALLOCATOR_PROC(object_pool_allocator_proc) {
+    Object_Pool<T> *op = (Object_Pool<T> *)allocator_data;
+    assert(op != null);
+
+    Allocator a = op->pool.block_allocator;
+    const s64 slot_size = object_pool_slot_size<T>();
+
+    switch (mode) {
+        case ALLOCATOR_ALLOCATE:
+        case ALLOCATOR_ALLOCATE_ALIGNED:
+        case ALLOCATOR_ALLOCATE_UNINITIALIZED: {
+            s64 alignment = (mode == ALLOCATOR_ALLOCATE_ALIGNED) ? old_size : 0;
+            if ((size <= slot_size) && (alignment <= object_pool_slot_alignment<T>())) return object_pool_get(op);
+
+            u8 *result = (u8 *)allocator_call(a, mode, size, old_size);
+            if (result) object_pool_large_insert(&op->large_allocations, result);
+            return result;
+        } break;
+
+        case ALLOCATOR_RESIZE: {
+            if (!old_memory) return object_pool_allocator_proc<T>(ALLOCATOR_ALLOCATE, size, 0, null, allocator_data);
+
+            bool large = object_pool_remove_large_allocation(op, old_memory);
+            if (!large && (size <= slot_size)) {
+                if (old_size < size) memory_zero((u8 *)old_memory + old_size, (umm)(size - old_size));
+                return old_memory;
+            }
+
+            if (large && (size > slot_size)) {
+                u8 *result = (u8 *)a.proc(ALLOCATOR_RESIZE, size, old_size, old_memory, a.data);
+                object_pool_large_insert(&op->large_allocations, result ? result : (u8 *)old_memory);
+                return result;
+            }
+
+            void *result = object_pool_allocator_proc<T>(ALLOCATOR_ALLOCATE, size, 0, null, allocator_data);
+            if (!result) {
+                if (large) object_pool_large_insert(&op->large_allocations, (u8 *)old_memory);
+                return null;
+            }
+
+            memcpy(result, old_memory, (umm)Min(old_size, size));
+
+            if (large) {
+                a.proc(ALLOCATOR_FREE, 0, 0, old_memory, a.data);
+            } else {
+                object_pool_put(op, (T *)old_memory);
+            }
+
+            return result;
+        } break;
+
+        case ALLOCATOR_FREE:
+            if (!old_memory) return null;
+
+            if (object_pool_remove_large_allocation(op, old_memory)) {
+                a.proc(ALLOCATOR_FREE, 0, 0, old_memory, a.data);
+            } else {
+                object_pool_put(op, (T *)old_memory);
+            }
+            return null;
+
+        case ALLOCATOR_FREE_ALL:
+            object_pool_reset(op);
+            return null;
+
+        case ALLOCATOR_CAPS:
+            return (void *)(umm)(ALLOCATOR_CAPS_FREE | ALLOCATOR_CAPS_FREE_ALL | ALLOCATOR_CAPS_RESIZE_IN_PLACE);
+
+        case ALLOCATOR_USABLE_SIZE:
+            return null;
+
+        default:
+            assert(false);
+            return null;
+    }
+}
+
+template<typename T>
+Allocator object_pool_allocator(Object_Pool<T> *op) {
+    Allocator result = {object_pool_allocator_dispatch, op};
+    return result;
+}
+
+
+/*
+
+    Concurrent pool allocator.
+
+    Threads bump allocate from the current memblock with an atomic
+    fetch-add, the thread that finds it full installs the next memblock
+    with a compare-and-swap. No locks are taken, block_allocator has to
+    be thread safe itself.
+
+    concurrent_pool_reset and concurrent_pool_release must only be called
+    when no thread is allocating. Blocks are only pushed to the unused list
+    at that point, so popping them while allocating is free of ABA.
+
+*/
+
+const s64 CONCURRENT_POOL_HEADER_SIZE = 64;  // Keeps the contended counter off the data.
+
+typedef struct Concurrent_Pool_Block {
+    struct Concurrent_Pool_Block *volatile next;
+
+    volatile s64 used;  // Can overshoot capacity, the block is full then.
+    s64 capacity;
+} Concurrent_Pool_Block;
+
+typedef struct Concurrent_Pool {
+    s64 memblock_size    = POOL_BUCKET_SIZE_DEFAULT;
+    s64 out_of_band_size = POOL_OUT_OF_BAND_SIZE_DEFAULT;
+    s64 alignment        = POOL_ALIGNMENT_DEFAULT;
+
+    Concurrent_Pool_Block *volatile current_block = null;  // Newest used block, older ones hang off next.
+    Concurrent_Pool_Block *volatile unused_blocks = null;
+    Concurrent_Pool_Block *volatile spare_block   = null;  // Lost an install race, used by the next one.
+    Concurrent_Pool_Block *volatile out_of_band   = null;
+
+    Allocator block_allocator = {heap_allocator, null};
+} Concurrent_Pool;
+
+void concurrent_pool_init(Concurrent_Pool *pool,
+                          s64 block_size = POOL_BUCKET_SIZE_DEFAULT,
+                          s64 alignment  = POOL_ALIGNMENT_DEFAULT,
+                          Allocator block_allocator = {heap_allocator, null});
+
+TINYRT_EXTERN void *concurrent_pool_get(Concurrent_Pool *pool, s64 nbytes);
+TINYRT_EXTERN void *concurrent_pool_get_aligned(Concurrent_Pool *pool, s64 nbytes, s64 alignment);
+TINYRT_EXTERN void concurrent_pool_reset(Concurrent_Pool *pool);
+TINYRT_EXTERN void concurrent_pool_release(Concurrent_Pool *pool);
+
+TINYRT_EXTERN ALLOCATOR_PROC(concurrent_pool_allocator_proc);
+
+
+/*
+
+    Slab allocator.
+
+    Small objects are served from segregated size classes, every class
+    keeps an intrusive free list so freeing and reusing is O(1).
+    Slabs are SLAB_SIZE aligned and carved out of bigger spans that come
+    from block_allocator, requests bigger than SLAB_MAX_OBJECT_SIZE go
+    to block_allocator directly.
+
+*/
+
+const s64 SLAB_SHIFT            = 16;
+const s64 SLAB_SIZE             = (s64)1 << SLAB_SHIFT;
+const s64 SLAB_HEADER_SIZE      = 64;
+const s64 SLAB_SPAN_COUNT       = 16;  // Slabs carved out of each span.
+const s64 SLAB_MAX_OBJECT_SIZE  = 2048;
+const s64 SLAB_SIZE_CLASS_COUNT = 24;
+
+typedef struct Slab_Size_Class {
+    s64 object_size;
+
+    u8 *free_list;    // Next pointer lives in the freed object.
+    u8 *current_pos;  // Bump pointer into the newest slab of this class.
+    u8 *current_end;
+} Slab_Size_Class;
+
+typedef struct Slab_Allocator {
+    Slab_Size_Class size_classes[SLAB_SIZE_CLASS_COUNT];
+    u8 size_class_lookup[SLAB_MAX_OBJECT_SIZE / 16 + 1];
+
+    u8 *span_pos        = null;
+    s64 span_slabs_left = 0;
+    Array<u8 *> spans;
+
+    // Open addressing set of (slab address >> SLAB_SHIFT), it tells
+    // slab objects from big allocations when freeing.
+    u64 *slab_lookup          = null;
+    s64 slab_lookup_capacity  = 0;
+    s64 slab_lookup_count     = 0;
+
+    Allocator block_allocator = {heap_allocator, null};
+} Slab_Allocator;
+
+void slab_init(Slab_Allocator *slab, Allocator block_allocator = {heap_allocator, null});
+
+TINYRT_EXTERN void *slab_get(Slab_Allocator *slab, s64 nbytes);
+TINYRT_EXTERN void *slab_get_uninitialized(Slab_Allocator *slab, s64 nbytes);
+TINYRT_EXTERN void *slab_get_aligned(Slab_Allocator *slab, s64 nbytes, s64 alignment);
+TINYRT_EXTERN void slab_free(Slab_Allocator *slab, void *memory);
+TINYRT_EXTERN void slab_release(Slab_Allocator *slab);
+
+TINYRT_EXTERN ALLOCATOR_PROC(slab_allocator_proc);
+
 #endif  // GENERAL_POOL_INCLUDE_H
 
 
-#ifdef POOL_IMPLEMENTATION
+#if defined(POOL_IMPLEMENTATION) && !defined(POOL_IMPLEMENTATION_INCLUDED)
+#define POOL_IMPLEMENTATION_INCLUDED
 
 static void pool_cycle_new_block(Pool *pool) {
     if (!pool->block_allocator.proc) {
@@ -80,14 +503,16 @@ static void pool_cycle_new_block(Pool *pool) {
     u8 *new_block;
     if (pool->unused_memblocks.count) {
         array_pop(&pool->unused_memblocks, &new_block);
+        pool->purged_memblocks = Min(pool->purged_memblocks, pool->unused_memblocks.count);
     } else {
         assert(a.proc != null);
-        new_block = (u8 *)a.proc(ALLOCATOR_ALLOCATE, pool->memblock_size, 0, null, a.data);
+        new_block = (u8 *)allocator_call(a, ALLOCATOR_ALLOCATE_UNINITIALIZED, pool->memblock_size);
     }
 
     pool->bytes_left = pool->memblock_size;
     pool->current_memblock = new_block;
     pool->current_pos      = new_block;
+    pool->last_allocation  = null;
 }
 
 void set_allocators(Pool *pool, Allocator block_allocator, Allocator array_allocator) {
@@ -111,46 +536,81 @@ void set_allocators(Pool *pool, Allocator block_allocator, Allocator array_alloc
 
 TINYRT_EXTERN void *pool_get(Pool *pool, s64 nbytes) {
     assert(pool != null);
+    return pool_get_aligned(pool, nbytes, pool->alignment);
+}
+
+TINYRT_EXTERN void *pool_get_aligned(Pool *pool, s64 nbytes, s64 alignment) {
+    assert(pool != null);
+    assert(is_power_of_2(alignment));
 
     s64 extra = (pool->alignment - (nbytes % pool->alignment)) % pool->alignment;
     nbytes += extra;
 
-    if (nbytes >= POOL_OUT_OF_BAND_SIZE_DEFAULT) {
-        assert(pool->block_allocator.proc != null);
-        u8 *memory = (u8 *)pool->block_allocator.proc(ALLOCATOR_ALLOCATE, nbytes, 0, null, pool->block_allocator.data);
-        
-        if (memory) array_add(&pool->out_of_band_allocations, memory);
+    if (nbytes + alignment - 1 >= POOL_OUT_OF_BAND_SIZE_DEFAULT) {
+        Allocator a = pool->block_allocator;
+        assert(a.proc != null);
+
+        // The list keeps the block to free, it is not the memory when it was aligned by hand.
+        u8 *memory;
+        void *base;
+        if (alignment > pool->alignment) {
+            memory = (u8 *)allocator_alloc_aligned(a, nbytes, alignment, &base);
+        } else {
+            memory = (u8 *)allocator_call(a, ALLOCATOR_ALLOCATE_UNINITIALIZED, nbytes);
+            base   = memory;
+        }
+
+        if (memory) array_add(&pool->out_of_band_allocations, (u8 *)base);
         return memory;
     }
 
-    if (pool->bytes_left < nbytes) {
+    // The block allocator only promises its own alignment for the memblock base.
+    s64 padding = (s64)align_forward_offset((umm)pool->current_pos, (umm)alignment);
+
+    if (pool->bytes_left < padding + nbytes) {
         pool_cycle_new_block(pool);
         if (!pool->current_memblock) return null;
+
+        padding = (s64)align_forward_offset((umm)pool->current_pos, (umm)alignment);
     }
 
-    void *result = pool->current_pos;
-    pool->current_pos += nbytes;
-    pool->bytes_left  -= nbytes;
+    u8 *result = pool->current_pos + padding;
+    pool->current_pos  = result + nbytes;
+    pool->bytes_left  -= padding + nbytes;
+
+    pool->last_allocation = result;
     return result;
 }
 
-TINYRT_EXTERN void pool_release(Pool *pool) {
-    pool_reset(pool);
+// Moves the end of the newest allocation, false if it is not the newest or does not fit.
+static bool pool_resize_last(Pool *pool, void *memory, s64 nbytes) {
+    if (!pool->last_allocation || (memory != pool->last_allocation)) return false;
 
-    assert(pool->block_allocator.proc != null);
-    for (s64 index = 0; index < pool->unused_memblocks.count; ++index) {
-        u8 *it = pool->unused_memblocks[index];
-        pool->block_allocator.proc(ALLOCATOR_FREE, 0, 0, it, pool->block_allocator.data);
-    }
-    pool->unused_memblocks.count = 0;
+    s64 extra = (pool->alignment - (nbytes % pool->alignment)) % pool->alignment;
+    nbytes += extra;
+
+    s64 available = (pool->current_pos - pool->last_allocation) + pool->bytes_left;
+    if (nbytes > available) return false;
+
+    pool->current_pos = pool->last_allocation + nbytes;
+    pool->bytes_left  = available - nbytes;
+    return true;
 }
 
-TINYRT_EXTERN void pool_reset(Pool *pool) {
+// Moves every memblock to unused_memblocks, returns how many were in use.
+static s64 pool_reset_memblocks(Pool *pool) {
+    s64 used_count = pool->used_memblocks.count;
+
     if (pool->current_memblock) {
         array_add(&pool->unused_memblocks, pool->current_memblock);
         pool->current_memblock = null;
+        used_count += 1;
     }
 
+    pool->current_pos     = null;
+    pool->bytes_left      = 0;
+    pool->last_allocation = null;
+
     for (s64 index = 0; index < pool->used_memblocks.count; ++index) {
         array_add(&pool->unused_memblocks, pool->used_memblocks[index]);
     }
@@ -161,32 +621,643 @@ TINYRT_EXTERN void pool_reset(Pool *pool) {
         pool->block_allocator.proc(ALLOCATOR_FREE, 0, 0, it, pool->block_allocator.data);
     }
     pool->out_of_band_allocations.count = 0;
+
+    return used_count;
 }
 
-TINYRT_EXTERN ALLOCATOR_PROC(pool_allocator_proc) {
-    UNUSED(old_size);
-    UNUSED(old_memory);
+// Frees unused memblocks from the back until keep are left.
+static void pool_free_unused_memblocks(Pool *pool, s64 keep) {
+    assert(pool->block_allocator.proc != null);
 
+    while (pool->unused_memblocks.count > keep) {
+        u8 *it = pool->unused_memblocks[pool->unused_memblocks.count - 1];
+        pool->unused_memblocks.count -= 1;
+
+        pool->block_allocator.proc(ALLOCATOR_FREE, 0, 0, it, pool->block_allocator.data);
+        pool->released_bytes += pool->memblock_size;
+    }
+
+    pool->purged_memblocks = Min(pool->purged_memblocks, pool->unused_memblocks.count);
+}
+
+TINYRT_EXTERN void pool_release(Pool *pool) {
+    pool_reset_memblocks(pool);
+    pool_free_unused_memblocks(pool, 0);
+
+    pool->retain_target = 0;
+}
+
+TINYRT_EXTERN void pool_reset(Pool *pool) {
+    // Blocks still unused here sat idle for the whole cycle. New blocks are
+    // taken from the back, so the purged ones stay at the front.
+    if (pool->purge_retained) {
+        for (s64 index = pool->purged_memblocks; index < pool->unused_memblocks.count; ++index) {
+            os_purge_memory(pool->unused_memblocks[index], pool->memblock_size);
+        }
+        pool->purged_memblocks = pool->unused_memblocks.count;
+    }
+
+    s64 used_count = pool_reset_memblocks(pool);
+    s64 keep = pool->unused_memblocks.count;
+
+    if (pool->retain_decay_resets > 0) {
+        if (pool->retain_target > used_count) {
+            // Close a share of the gap to the current need on every reset.
+            s64 gap = pool->retain_target - used_count;
+            pool->retain_target -= (gap + pool->retain_decay_resets - 1) / pool->retain_decay_resets;
+        } else {
+            pool->retain_target = used_count;
+        }
+
+        keep = Min(keep, pool->retain_target);
+    }
+
+    if (pool->retain_memblocks_max >= 0) keep = Min(keep, pool->retain_memblocks_max);
+
+    // Hot blocks at the back go first, the purged ones hold no memory anyway.
+    pool_free_unused_memblocks(pool, keep);
+}
+
+TINYRT_EXTERN Pool_Stats pool_get_stats(Pool *pool) {
+    Pool_Stats result;
+
+    s64 used_count = pool->used_memblocks.count + (pool->current_memblock ? 1 : 0);
+
+    result.used_bytes     = used_count * pool->memblock_size;
+    result.retained_bytes = pool->unused_memblocks.count * pool->memblock_size;
+    result.purged_bytes   = pool->purged_memblocks * pool->memblock_size;
+    result.released_bytes = pool->released_bytes;
+    return result;
+}
+
+TINYRT_EXTERN ALLOCATOR_PROC(pool_allocator_proc) {
     Pool *pool = (Pool *)allocator_data;
     assert(pool != null);
 
     switch (mode) {
         case ALLOCATOR_ALLOCATE:
+        case ALLOCATOR_ALLOCATE_UNINITIALIZED:
             return pool_get(pool, size);
 
-        case ALLOCATOR_RESIZE:
-            // We do not resize our pools.
+        case ALLOCATOR_ALLOCATE_ALIGNED:
+            return pool_get_aligned(pool, size, Max(old_size, pool->alignment));
+
+        case ALLOCATOR_RESIZE: {
+            // The newest allocation grows in place, anything else is copied.
+            if (old_memory && pool_resize_last(pool, old_memory, size)) return old_memory;
+
+            void *result = pool_get(pool, size);
+            if (!result) return null;
+
+            if (old_memory && (old_size > 0)) {
+                memcpy(result, old_memory, (umm)Min(old_size, size));
+            }
+
+            return result;
+        } break;
+
+        case ALLOCATOR_FREE: {
+            // Only the newest allocation gives its memory back.
+            if (old_memory && pool_resize_last(pool, old_memory, 0)) {
+                pool->last_allocation = null;
+            }
+
+            return null;
+        } break;
+
+        case ALLOCATOR_FREE_ALL: {
+            pool_release(pool);
+            return null;
+        } break;
+
+        case ALLOCATOR_CAPS:
+            return (void *)(umm)(ALLOCATOR_CAPS_FREE_ALL | ALLOCATOR_CAPS_RESIZE_IN_PLACE | ALLOCATOR_CAPS_USABLE_SIZE);
+
+        case ALLOCATOR_USABLE_SIZE:
+            // Every allocation is padded to the pool alignment.
+            return (void *)(umm)align_forward(size, pool->alignment);
+
+        default:
             assert(false);
             return null;
+    }
+}
+
+// Answers the modes past ALLOCATOR_ALLOCATE_ALIGNED, see allocator_call.
+static bool pool_allocator_declared = allocator_declare_extended_modes(pool_allocator_proc);
+
+TINYRT_EXTERN ALLOCATOR_PROC(object_pool_allocator_dispatch) {
+    assert(allocator_data != null);
+
+    Allocator_Proc *proc = *(Allocator_Proc **)allocator_data;
+    return proc(mode, size, old_size, old_memory, allocator_data);
+}
+
+// Declared once here, the typed procs would each take a slot of the table.
+static bool object_pool_allocator_declared = allocator_declare_extended_modes(object_pool_allocator_dispatch);
+
+
+void concurrent_pool_init(Concurrent_Pool *pool, s64 block_size, s64 alignment, Allocator block_allocator) {
+    if (!block_allocator.proc) {
+        block_allocator.proc = heap_allocator;
+        block_allocator.data = null;
+    }
+
+    assert(block_size > CONCURRENT_POOL_HEADER_SIZE);
+    assert(is_power_of_2(alignment));
+
+    pool->memblock_size    = block_size;
+    pool->out_of_band_size = Min(POOL_OUT_OF_BAND_SIZE_DEFAULT, block_size - CONCURRENT_POOL_HEADER_SIZE);  // Smaller blocks would never fit.
+    pool->alignment        = alignment;
+
+    pool->current_block = null;
+    pool->unused_blocks = null;
+    pool->spare_block   = null;
+    pool->out_of_band   = null;
+
+    pool->block_allocator = block_allocator;
+}
+
+static Concurrent_Pool_Block *concurrent_pool_take_block(Concurrent_Pool *pool) {
+    Concurrent_Pool_Block *result = (Concurrent_Pool_Block *)atomic_load_pointer((void *volatile *)&pool->spare_block);
+    if (result && atomic_compare_and_swap_pointer((void *volatile *)&pool->spare_block, result, null)) return result;
+
+    while (true) {
+        result = (Concurrent_Pool_Block *)atomic_load_pointer((void *volatile *)&pool->unused_blocks);
+        if (!result) break;
+
+        // Blocks are never freed or pushed back while threads allocate, so next is safe to read.
+        // It can be stale when another thread took the block first, the swap fails then.
+        void *next = atomic_load_pointer((void *volatile *)&result->next);
+        if (atomic_compare_and_swap_pointer((void *volatile *)&pool->unused_blocks, result, next)) return result;
+    }
+
+    Allocator a = pool->block_allocator;
+    assert(a.proc != null);
+
+    result = (Concurrent_Pool_Block *)a.proc(ALLOCATOR_ALLOCATE, pool->memblock_size, 0, null, a.data);
+    if (!result) return null;
+
+    result->capacity = pool->memblock_size - CONCURRENT_POOL_HEADER_SIZE;
+    return result;
+}
+
+// A block that was taken but not installed waits for the next install.
+static void concurrent_pool_keep_spare(Concurrent_Pool *pool, Concurrent_Pool_Block *block) {
+    if (!atomic_compare_and_swap_pointer((void *volatile *)&pool->spare_block, null, block)) {
+        Allocator a = pool->block_allocator;
+        a.proc(ALLOCATOR_FREE, 0, 0, block, a.data);
+    }
+}
+
+static void *concurrent_pool_get_out_of_band(Concurrent_Pool *pool, s64 nbytes) {
+    Allocator a = pool->block_allocator;
+    assert(a.proc != null);
+
+    Concurrent_Pool_Block *block = (Concurrent_Pool_Block *)a.proc(ALLOCATOR_ALLOCATE, nbytes + CONCURRENT_POOL_HEADER_SIZE, 0, null, a.data);
+    if (!block) return null;
+
+    block->capacity = nbytes;
+
+    // Only pushed until the next reset, so a plain CAS push is enough.
+    while (true) {
+        Concurrent_Pool_Block *head = (Concurrent_Pool_Block *)atomic_load_pointer((void *volatile *)&pool->out_of_band);
+        block->next = head;
+        if (atomic_compare_and_swap_pointer((void *volatile *)&pool->out_of_band, head, block)) break;
+    }
+
+    return (u8 *)block + CONCURRENT_POOL_HEADER_SIZE;
+}
+
+TINYRT_EXTERN void *concurrent_pool_get(Concurrent_Pool *pool, s64 nbytes) {
+    assert(pool != null);
+
+    s64 extra = (pool->alignment - (nbytes % pool->alignment)) % pool->alignment;
+    nbytes += extra;
+
+    if (nbytes >= pool->out_of_band_size) return concurrent_pool_get_out_of_band(pool, nbytes);
+
+    while (true) {
+        Concurrent_Pool_Block *block = (Concurrent_Pool_Block *)atomic_load_pointer((void *volatile *)&pool->current_block);
+
+        if (block) {
+            s64 offset = atomic_fetch_add(&block->used, nbytes);
+            if (offset + nbytes <= block->capacity) return (u8 *)block + CONCURRENT_POOL_HEADER_SIZE + offset;
+        }
+
+        // The block is full, race the other threads to install the next one.
+        Concurrent_Pool_Block *new_block = concurrent_pool_take_block(pool);
+        if (!new_block) return null;
+
+        // out_of_band_size was set past the block capacity, this never fits a block.
+        if (nbytes > new_block->capacity) {
+            concurrent_pool_keep_spare(pool, new_block);
+            return concurrent_pool_get_out_of_band(pool, nbytes);
+        }
+
+        atomic_store_pointer((void *volatile *)&new_block->next, block);
+        new_block->used = nbytes;
+
+        if (atomic_compare_and_swap_pointer((void *volatile *)&pool->current_block, block, new_block)) {
+            return (u8 *)new_block + CONCURRENT_POOL_HEADER_SIZE;
+        }
+
+        // Somebody else won, keep the block around for the next install.
+        concurrent_pool_keep_spare(pool, new_block);
+    }
+}
+
+// Block bases only have the alignment of block_allocator, so we pad by the whole alignment.
+TINYRT_EXTERN void *concurrent_pool_get_aligned(Concurrent_Pool *pool, s64 nbytes, s64 alignment) {
+    assert(pool != null);
+    assert(is_power_of_2(alignment));
+
+    if (alignment <= pool->alignment) return concurrent_pool_get(pool, nbytes);
+
+    u8 *memory = (u8 *)concurrent_pool_get(pool, nbytes + alignment);
+    if (!memory) return null;
+
+    return align_forward_pointer(memory, alignment);
+}
+
+TINYRT_EXTERN void concurrent_pool_reset(Concurrent_Pool *pool) {
+    Concurrent_Pool_Block *block = pool->current_block;
+    while (block) {
+        Concurrent_Pool_Block *next = block->next;
+
+        block->used = 0;
+        block->next = pool->unused_blocks;
+        pool->unused_blocks = block;
+
+        block = next;
+    }
+    pool->current_block = null;
+
+    Allocator a = pool->block_allocator;
+
+    block = pool->out_of_band;
+    while (block) {
+        Concurrent_Pool_Block *next = block->next;
+        a.proc(ALLOCATOR_FREE, 0, 0, block, a.data);
+        block = next;
+    }
+    pool->out_of_band = null;
+}
+
+TINYRT_EXTERN void concurrent_pool_release(Concurrent_Pool *pool) {
+    concurrent_pool_reset(pool);
+
+    Allocator a = pool->block_allocator;
+    assert(a.proc != null);
+
+    Concurrent_Pool_Block *block = pool->unused_blocks;
+    while (block) {
+        Concurrent_Pool_Block *next = block->next;
+        a.proc(ALLOCATOR_FREE, 0, 0, block, a.data);
+        block = next;
+    }
+    pool->unused_blocks = null;
+
+    if (pool->spare_block) a.proc(ALLOCATOR_FREE, 0, 0, pool->spare_block, a.data);
+    pool->spare_block = null;
+}
+
+TINYRT_EXTERN ALLOCATOR_PROC(concurrent_pool_allocator_proc) {
+    Concurrent_Pool *pool = (Concurrent_Pool *)allocator_data;
+    assert(pool != null);
+
+    switch (mode) {
+        case ALLOCATOR_ALLOCATE:
+        case ALLOCATOR_ALLOCATE_UNINITIALIZED:
+            return concurrent_pool_get(pool, size);
+
+        case ALLOCATOR_ALLOCATE_ALIGNED:
+            return concurrent_pool_get_aligned(pool, size, old_size);
+
+        case ALLOCATOR_RESIZE: {
+            // Other threads may have allocated past the old memory, always copy.
+            void *result = concurrent_pool_get(pool, size);
+            if (!result) return null;
+
+            if (old_memory && (old_size > 0)) {
+                memcpy(result, old_memory, (umm)Min(old_size, size));
+            }
+
+            return result;
+        } break;
 
         case ALLOCATOR_FREE:
-            // Not supported.
+            // Memory goes back all at once on reset.
+            return null;
+
+        case ALLOCATOR_FREE_ALL:
+            concurrent_pool_release(pool);
+            return null;
+
+        case ALLOCATOR_CAPS:
+            return (void *)(umm)ALLOCATOR_CAPS_FREE_ALL;
+
+        case ALLOCATOR_USABLE_SIZE:
+            return null;
+
+        default:
             assert(false);
             return null;
+    }
+}
 
-        case ALLOCATOR_FREE_ALL: {
-            pool_release(pool);
+// Answers the modes past ALLOCATOR_ALLOCATE_ALIGNED, see allocator_call.
+static bool concurrent_pool_allocator_declared = allocator_declare_extended_modes(concurrent_pool_allocator_proc);
+
+
+static const s64 slab_object_sizes[SLAB_SIZE_CLASS_COUNT] = {
+      16,   32,   48,   64,   80,   96,  112,  128,
+     160,  192,  224,  256,  320,  384,  448,  512,
+     640,  768,  896, 1024, 1280, 1536, 1792, 2048,
+};
+
+void slab_init(Slab_Allocator *slab, Allocator block_allocator) {
+    if (!block_allocator.proc) {
+        block_allocator.proc = heap_allocator;
+        block_allocator.data = null;
+    }
+
+    memory_zero(slab->size_classes, size_of(slab->size_classes));
+
+    s64 class_index = 0;
+    for (s64 index = 0; index < (s64)array_count(slab->size_class_lookup); ++index) {
+        while (slab_object_sizes[class_index] < index * 16) class_index += 1;
+        slab->size_class_lookup[index] = (u8)class_index;
+    }
+
+    for (s64 index = 0; index < SLAB_SIZE_CLASS_COUNT; ++index) {
+        slab->size_classes[index].object_size = slab_object_sizes[index];
+    }
+
+    slab->span_pos        = null;
+    slab->span_slabs_left = 0;
+
+    slab->slab_lookup          = null;
+    slab->slab_lookup_capacity = 0;
+    slab->slab_lookup_count    = 0;
+
+    slab->block_allocator = block_allocator;
+}
+
+static inline s64 slab_lookup_slot(u64 key, s64 capacity) {
+    return (s64)((key * 11400714819323198485ull) >> 32) & (capacity - 1);
+}
+
+static bool slab_lookup_contains(Slab_Allocator *slab, u64 key) {
+    if (!slab->slab_lookup_capacity) return false;
+
+    s64 slot = slab_lookup_slot(key, slab->slab_lookup_capacity);
+    while (slab->slab_lookup[slot]) {
+        if (slab->slab_lookup[slot] == key) return true;
+        slot = (slot + 1) & (slab->slab_lookup_capacity - 1);
+    }
+
+    return false;
+}
+
+static void slab_lookup_insert(Slab_Allocator *slab, u64 key) {
+    if ((slab->slab_lookup_count + 1) * 2 > slab->slab_lookup_capacity) {
+        // Keep the load factor under one half.
+        s64 old_capacity = slab->slab_lookup_capacity;
+        u64 *old_lookup  = slab->slab_lookup;
+
+        s64 new_capacity = old_capacity ? old_capacity * 2 : 64;
+
+        u64 *new_lookup = (u64 *)heap_alloc(new_capacity * size_of(u64));
+        assert(new_lookup != null);
+
+        for (s64 index = 0; index < old_capacity; ++index) {
+            u64 it = old_lookup[index];
+            if (!it) continue;
+
+            s64 slot = slab_lookup_slot(it, new_capacity);
+            while (new_lookup[slot]) slot = (slot + 1) & (new_capacity - 1);
+            new_lookup[slot] = it;
+        }
+
+        if (old_lookup) heap_free(old_lookup);
+
+        slab->slab_lookup          = new_lookup;
+        slab->slab_lookup_capacity = new_capacity;
+    }
+
+    s64 slot = slab_lookup_slot(key, slab->slab_lookup_capacity);
+    while (slab->slab_lookup[slot]) slot = (slot + 1) & (slab->slab_lookup_capacity - 1);
+
+    slab->slab_lookup[slot] = key;
+    slab->slab_lookup_count += 1;
+}
+
+static u8 *slab_new(Slab_Allocator *slab, s64 class_index) {
+    if (!slab->span_slabs_left) {
+        Allocator a = slab->block_allocator;
+        if (!a.proc) {
+            write_string("You must call slab_init before using it!\n", true);
+            assert(false);
+            return null;
+        }
+
+        // One extra slab worth of bytes lets us align the span to SLAB_SIZE.
+        u8 *span = (u8 *)a.proc(ALLOCATOR_ALLOCATE, SLAB_SIZE * (SLAB_SPAN_COUNT + 1), 0, null, a.data);
+        if (!span) return null;
+
+        array_add(&slab->spans, span);
+
+        slab->span_pos        = align_forward_pointer(span, SLAB_SIZE);
+        slab->span_slabs_left = SLAB_SPAN_COUNT;
+    }
+
+    u8 *result = slab->span_pos;
+    slab->span_pos        += SLAB_SIZE;
+    slab->span_slabs_left -= 1;
+
+    *(s64 *)result = class_index;
+    slab_lookup_insert(slab, (u64)((umm)result >> SLAB_SHIFT));
+
+    return result;
+}
+
+// Recycled objects keep whatever was written to them last.
+TINYRT_EXTERN void *slab_get_uninitialized(Slab_Allocator *slab, s64 nbytes) {
+    assert(slab != null);
+
+    if (nbytes > SLAB_MAX_OBJECT_SIZE) {
+        Allocator a = slab->block_allocator;
+        assert(a.proc != null);
+        return allocator_call(a, ALLOCATOR_ALLOCATE_UNINITIALIZED, nbytes);
+    }
+
+    s64 class_index = slab->size_class_lookup[(nbytes + 15) / 16];
+    Slab_Size_Class *size_class = &slab->size_classes[class_index];
+
+    u8 *result = size_class->free_list;
+    if (result) {
+        size_class->free_list = *(u8 **)result;
+    } else {
+        if (size_class->current_pos + size_class->object_size > size_class->current_end) {
+            u8 *new_slab = slab_new(slab, class_index);
+            if (!new_slab) return null;
+
+            size_class->current_pos = new_slab + SLAB_HEADER_SIZE;
+            size_class->current_end = new_slab + SLAB_SIZE;
+        }
+
+        result = size_class->current_pos;
+        size_class->current_pos += size_class->object_size;
+    }
+
+    return result;
+}
+
+TINYRT_EXTERN void *slab_get(Slab_Allocator *slab, s64 nbytes) {
+    assert(slab != null);
+
+    if (nbytes > SLAB_MAX_OBJECT_SIZE) {
+        Allocator a = slab->block_allocator;
+        assert(a.proc != null);
+        return a.proc(ALLOCATOR_ALLOCATE, nbytes, 0, null, a.data);
+    }
+
+    u8 *result = (u8 *)slab_get_uninitialized(slab, nbytes);
+
+    // Objects get recycled, so we zero them like heap_allocator does.
+    if (result) memory_zero(result, (umm)nbytes);
+    return result;
+}
+
+// Objects start SLAB_HEADER_SIZE bytes into an aligned slab, so a class whose
+// object size is a multiple of the alignment hands out aligned objects.
+TINYRT_EXTERN void *slab_get_aligned(Slab_Allocator *slab, s64 nbytes, s64 alignment) {
+    assert(slab != null);
+    assert(is_power_of_2(alignment));
+
+    if (alignment <= 16) return slab_get(slab, nbytes);
+
+    if ((alignment <= SLAB_HEADER_SIZE) && (nbytes <= SLAB_MAX_OBJECT_SIZE)) {
+        s64 class_index = slab->size_class_lookup[(align_forward(nbytes, alignment) + 15) / 16];
+
+        while ((class_index < SLAB_SIZE_CLASS_COUNT) && (slab->size_classes[class_index].object_size % alignment)) {
+            class_index += 1;
+        }
+
+        if (class_index < SLAB_SIZE_CLASS_COUNT) {
+            return slab_get(slab, slab->size_classes[class_index].object_size);
+        }
+    }
+
+    Allocator a = slab->block_allocator;
+    return allocator_call(a, ALLOCATOR_ALLOCATE_ALIGNED, nbytes, alignment);
+}
+
+TINYRT_EXTERN void slab_free(Slab_Allocator *slab, void *memory) {
+    assert(slab != null);
+    if (!memory) return;
+
+    u64 key = (u64)((umm)memory >> SLAB_SHIFT);
+    if (!slab_lookup_contains(slab, key)) {
+        Allocator a = slab->block_allocator;
+        a.proc(ALLOCATOR_FREE, 0, 0, memory, a.data);
+        return;
+    }
+
+    u8 *slab_base = (u8 *)((umm)key << SLAB_SHIFT);
+    Slab_Size_Class *size_class = &slab->size_classes[*(s64 *)slab_base];
+
+    *(u8 **)memory = size_class->free_list;
+    size_class->free_list = (u8 *)memory;
+}
+
+TINYRT_EXTERN void slab_release(Slab_Allocator *slab) {
+    Allocator a = slab->block_allocator;
+    assert(a.proc != null);
+
+    for (s64 index = 0; index < slab->spans.count; ++index) {
+        a.proc(ALLOCATOR_FREE, 0, 0, slab->spans[index], a.data);
+    }
+    array_free(&slab->spans);
+
+    if (slab->slab_lookup) heap_free(slab->slab_lookup);
+
+    slab_init(slab, a);
+}
+
+TINYRT_EXTERN ALLOCATOR_PROC(slab_allocator_proc) {
+    Slab_Allocator *slab = (Slab_Allocator *)allocator_data;
+    assert(slab != null);
+
+    switch (mode) {
+        case ALLOCATOR_ALLOCATE:
+            return slab_get(slab, size);
+
+        case ALLOCATOR_ALLOCATE_UNINITIALIZED:
+            return slab_get_uninitialized(slab, size);
+
+        case ALLOCATOR_ALLOCATE_ALIGNED:
+            return slab_get_aligned(slab, size, old_size);
+
+        case ALLOCATOR_RESIZE: {
+            if (!old_memory) return slab_get(slab, size);
+
+            u64 key = (u64)((umm)old_memory >> SLAB_SHIFT);
+            if (!slab_lookup_contains(slab, key)) {
+                if (size > SLAB_MAX_OBJECT_SIZE) {
+                    Allocator a = slab->block_allocator;
+                    return a.proc(ALLOCATOR_RESIZE, size, old_size, old_memory, a.data);
+                }
+
+                // Shrinking a big allocation into a slab object.
+                void *result = slab_get(slab, size);
+                if (!result) return null;
+
+                memcpy(result, old_memory, (umm)Min(old_size, size));
+                slab_free(slab, old_memory);
+                return result;
+            }
+
+            u8 *slab_base = (u8 *)((umm)key << SLAB_SHIFT);
+            s64 object_size = slab->size_classes[*(s64 *)slab_base].object_size;
+
+            if (size <= object_size) {
+                if (old_size < size) memory_zero((u8 *)old_memory + old_size, (umm)(size - old_size));
+                return old_memory;
+            }
+
+            void *result = slab_get(slab, size);
+            if (!result) return null;
+
+            memcpy(result, old_memory, (umm)Min(old_size, object_size));
+            slab_free(slab, old_memory);
+            return result;
+        } break;
+
+        case ALLOCATOR_FREE:
+            slab_free(slab, old_memory);
             return null;
+
+        case ALLOCATOR_FREE_ALL:
+            slab_release(slab);
+            return null;
+
+        case ALLOCATOR_CAPS:
+            return (void *)(umm)(ALLOCATOR_CAPS_FREE | ALLOCATOR_CAPS_FREE_ALL | ALLOCATOR_CAPS_RESIZE_IN_PLACE |
+                                 ALLOCATOR_CAPS_USABLE_SIZE | ALLOCATOR_CAPS_ZEROED);
+
+        case ALLOCATOR_USABLE_SIZE: {
+            if (!old_memory) return null;
+
+            u64 key = (u64)((umm)old_memory >> SLAB_SHIFT);
+            if (!slab_lookup_contains(slab, key)) {
+                Allocator a = slab->block_allocator;
+                return allocator_call(a, ALLOCATOR_USABLE_SIZE, size, 0, old_memory);
+            }
+
+            u8 *slab_base = (u8 *)((umm)key << SLAB_SHIFT);
+            return (void *)(umm)slab->size_classes[*(s64 *)slab_base].object_size;
         } break;
 
         default:
@@ -195,4 +1266,7 @@ TINYRT_EXTERN ALLOCATOR_PROC(pool_allocator_proc) {
     }
 }
 
+// Answers the modes past ALLOCATOR_ALLOCATE_ALIGNED, see allocator_call.
+static bool slab_allocator_declared = allocator_declare_extended_modes(slab_allocator_proc);
+
 #endif  // POOL_IMPLEMENTATION
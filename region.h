@@ -0,0 +1,390 @@
+#ifndef GENERAL_REGION_INCLUDE_H
+#define GENERAL_REGION_INCLUDE_H
+/*
+
+    Region block allocator.
+
+    Hands out fixed size blocks carved from big regions of virtual memory,
+    meant to be used as Pool::block_allocator. Fewer, bigger mappings
+    mean fewer TLB misses, and faulting a region in up front takes the
+    first touch page faults out of the code using the blocks.
+
+    On Linux a region first tries reserved huge pages (MAP_HUGETLB) when
+    use_hugetlb is set, then normal pages advised with MADV_HUGEPAGE.
+    If the kernel has no huge pages to give, the region silently ends up
+    with normal pages. Other platforms get plain committed regions.
+
+    Requests that do not fit a block go to the fallback allocator.
+
+        Region_Allocator region;
+        region_init(&region);
+
+        Pool pool;
+        pool_init(&pool);
+        set_allocators(&pool, {region_allocator_proc, &region});
+
+
+    To include region implementation as cpp file use:
+
+    #define REGION_IMPLEMENTATION
+    #include "region.h"
+
+*/
+
+#include "general.h"
+#include "array.h"
+
+
+const s64 REGION_BLOCK_SIZE_DEFAULT = KB(64);
+const s64 REGION_SIZE_DEFAULT       = MB(4);
+const s64 REGION_HUGE_PAGE_SIZE     = MB(2);  // Regions start on this boundary.
+const s64 REGION_LOOKUP_SHIFT       = 21;     // The lookup keys addresses by huge page.
+
+// Every huge page a region touches has an entry, key 0 marks an empty one.
+typedef struct Region_Lookup_Entry {
+    u64 key;
+    u8 *region;
+} Region_Lookup_Entry;
+
+typedef struct Region_Allocator {
+    s64 block_size  = REGION_BLOCK_SIZE_DEFAULT;
+    s64 region_size = REGION_SIZE_DEFAULT;
+
+    bool huge_pages  = true;   // Advise transparent huge pages.
+    bool use_hugetlb = false;  // Try reserved huge pages first, see /proc/sys/vm/nr_hugepages.
+    bool prefault    = false;  // Fault every page of a region in when it is mapped.
+
+    u8 *current_pos = null;  // Uncarved part of the newest region.
+    u8 *current_end = null;
+    u8 *free_blocks = null;  // Next pointer lives in the freed block.
+
+    Array<u8 *> regions;
+    s64 hugetlb_regions = 0;  // How many regions got MAP_HUGETLB pages.
+
+    // Open addressing table for region_owns, the load factor stays under one half.
+    Region_Lookup_Entry *lookup = null;
+    s64 lookup_capacity = 0;
+    s64 lookup_count    = 0;
+
+    Allocator fallback = {heap_allocator, null};
+} Region_Allocator;
+
+void region_init(Region_Allocator *region,
+                 s64 block_size  = REGION_BLOCK_SIZE_DEFAULT,
+                 s64 region_size = REGION_SIZE_DEFAULT,
+                 Allocator fallback = {heap_allocator, null});
+
+TINYRT_EXTERN void *region_get_block(Region_Allocator *region);
+TINYRT_EXTERN void region_free_block(Region_Allocator *region, void *block);
+TINYRT_EXTERN bool region_owns(Region_Allocator *region, void *memory);
+TINYRT_EXTERN void region_release(Region_Allocator *region);
+
+TINYRT_EXTERN ALLOCATOR_PROC(region_allocator_proc);
+
+#endif  // GENERAL_REGION_INCLUDE_H
+
+
+#if defined(REGION_IMPLEMENTATION) && !defined(REGION_IMPLEMENTATION_INCLUDED)
+#define REGION_IMPLEMENTATION_INCLUDED
+
+#if OS_LINUX
+#include <sys/mman.h>
+#endif
+
+void region_init(Region_Allocator *region, s64 block_size, s64 region_size, Allocator fallback) {
+    if (!fallback.proc) {
+        fallback.proc = heap_allocator;
+        fallback.data = null;
+    }
+
+    assert(block_size >= (s64)size_of(u8 *));
+    assert(region_size >= block_size);
+
+    // Huge pages can only be unmapped as a whole.
+    region_size = align_forward(region_size, REGION_HUGE_PAGE_SIZE);
+
+    region->block_size  = block_size;
+    region->region_size = region_size;
+
+    region->current_pos = null;
+    region->current_end = null;
+    region->free_blocks = null;
+
+    region->hugetlb_regions = 0;
+
+    region->lookup          = null;
+    region->lookup_capacity = 0;
+    region->lookup_count    = 0;
+
+    region->fallback = fallback;
+}
+
+static void region_prefault(u8 *memory, s64 size) {
+#if OS_LINUX && defined(MADV_POPULATE_WRITE)
+    if (madvise(memory, (size_t)size, MADV_POPULATE_WRITE) == 0) return;
+#endif
+
+    // Older kernels, touch every page by hand.
+    s64 page_size = os_get_page_size();
+    for (s64 offset = 0; offset < size; offset += page_size) {
+        ((volatile u8 *)memory)[offset] = 0;
+    }
+}
+
+static u8 *region_map(Region_Allocator *region) {
+    s64 size = region->region_size;
+
+#if OS_LINUX
+    if (region->use_hugetlb) {
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+        if (region->prefault) flags |= MAP_POPULATE;
+
+        void *memory = mmap(null, (size_t)size, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (memory != MAP_FAILED) {
+            region->hugetlb_regions += 1;
+            return (u8 *)memory;
+        }
+
+        // No reserved huge pages left, go on with normal ones.
+    }
+
+    // Over-map so the region can start on a huge page boundary.
+    s64 mapped_size = size + REGION_HUGE_PAGE_SIZE;
+
+    u8 *memory = (u8 *)mmap(null, (size_t)mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == (u8 *)MAP_FAILED) return null;
+
+    u8 *result = align_forward_pointer(memory, REGION_HUGE_PAGE_SIZE);
+
+    s64 head = result - memory;
+    s64 tail = mapped_size - head - size;
+    if (head) munmap(memory, (size_t)head);
+    if (tail) munmap(result + size, (size_t)tail);
+
+#if defined(MADV_HUGEPAGE)
+    // Fails when the kernel has no transparent huge pages, the region still works.
+    if (region->huge_pages) madvise(result, (size_t)size, MADV_HUGEPAGE);
+#endif
+#else
+    u8 *result = (u8 *)os_reserve_memory(size);
+    if (!result) return null;
+
+    if (!os_commit_memory(result, size)) {
+        os_release_memory(result, size);
+        return null;
+    }
+#endif
+
+    if (region->prefault) region_prefault(result, size);
+    return result;
+}
+
+static void region_unmap(Region_Allocator *region, u8 *memory) {
+#if OS_LINUX
+    munmap(memory, (size_t)region->region_size);
+#else
+    os_release_memory(memory, region->region_size);
+#endif
+}
+
+static inline s64 region_lookup_slot(u64 key, s64 capacity) {
+    return (s64)((key * 11400714819323198485ull) >> 32) & (capacity - 1);
+}
+
+static void region_lookup_insert(Region_Allocator *region, u64 key, u8 *memory) {
+    if ((region->lookup_count + 1) * 2 > region->lookup_capacity) {
+        s64 old_capacity = region->lookup_capacity;
+        Region_Lookup_Entry *old_lookup = region->lookup;
+
+        s64 new_capacity = old_capacity ? old_capacity * 2 : 64;
+
+        Region_Lookup_Entry *new_lookup = (Region_Lookup_Entry *)heap_alloc(new_capacity * size_of(Region_Lookup_Entry));
+        assert(new_lookup != null);
+
+        for (s64 index = 0; index < old_capacity; ++index) {
+            Region_Lookup_Entry it = old_lookup[index];
+            if (!it.key) continue;
+
+            s64 slot = region_lookup_slot(it.key, new_capacity);
+            while (new_lookup[slot].key) slot = (slot + 1) & (new_capacity - 1);
+            new_lookup[slot] = it;
+        }
+
+        if (old_lookup) heap_free(old_lookup);
+
+        region->lookup          = new_lookup;
+        region->lookup_capacity = new_capacity;
+    }
+
+    s64 slot = region_lookup_slot(key, region->lookup_capacity);
+    while (region->lookup[slot].key) slot = (slot + 1) & (region->lookup_capacity - 1);
+
+    region->lookup[slot].key    = key;
+    region->lookup[slot].region = memory;
+    region->lookup_count += 1;
+}
+
+// Regions that do not start on a huge page share a key with a neighbour, each gets its own entry.
+static void region_lookup_add(Region_Allocator *region, u8 *memory) {
+    u64 first = (u64)((umm)memory >> REGION_LOOKUP_SHIFT);
+    u64 last  = (u64)((umm)(memory + region->region_size - 1) >> REGION_LOOKUP_SHIFT);
+
+    for (u64 key = first; key <= last; ++key) region_lookup_insert(region, key, memory);
+}
+
+static void *region_take_block(Region_Allocator *region, bool zero) {
+    assert(region != null);
+
+    u8 *result = region->free_blocks;
+    if (result) {
+        region->free_blocks = *(u8 **)result;
+
+        // Recycled blocks are dirty, zero them like heap_allocator does.
+        if (zero) memory_zero(result, (umm)region->block_size);
+        return result;
+    }
+
+    if (region->current_pos + region->block_size > region->current_end) {
+        u8 *memory = region_map(region);
+        if (!memory) return null;
+
+        array_add(&region->regions, memory);
+        region_lookup_add(region, memory);
+
+        region->current_pos = memory;
+        region->current_end = memory + region->region_size;
+    }
+
+    result = region->current_pos;
+    region->current_pos += region->block_size;
+    return result;
+}
+
+TINYRT_EXTERN void *region_get_block(Region_Allocator *region) {
+    return region_take_block(region, true);
+}
+
+TINYRT_EXTERN void region_free_block(Region_Allocator *region, void *block) {
+    assert(region_owns(region, block));
+
+    *(u8 **)block = region->free_blocks;
+    region->free_blocks = (u8 *)block;
+}
+
+TINYRT_EXTERN bool region_owns(Region_Allocator *region, void *memory) {
+    if (!region->lookup_capacity) return false;
+
+    u8 *it  = (u8 *)memory;
+    u64 key = (u64)((umm)it >> REGION_LOOKUP_SHIFT);
+
+    s64 slot = region_lookup_slot(key, region->lookup_capacity);
+    while (region->lookup[slot].key) {
+        Region_Lookup_Entry *entry = &region->lookup[slot];
+        if ((entry->key == key) && (it >= entry->region) && (it < entry->region + region->region_size)) return true;
+
+        slot = (slot + 1) & (region->lookup_capacity - 1);
+    }
+
+    return false;
+}
+
+// Unmaps every region, blocks that went to the fallback allocator are not touched.
+TINYRT_EXTERN void region_release(Region_Allocator *region) {
+    for (s64 index = 0; index < region->regions.count; ++index) {
+        region_unmap(region, region->regions[index]);
+    }
+    array_free(&region->regions);
+
+    if (region->lookup) heap_free(region->lookup);
+    region->lookup          = null;
+    region->lookup_capacity = 0;
+    region->lookup_count    = 0;
+
+    region->current_pos = null;
+    region->current_end = null;
+    region->free_blocks = null;
+
+    region->hugetlb_regions = 0;
+}
+
+// Blocks only serve requests bigger than half a block, so small
+// out-of-band allocations do not eat a whole block each.
+static inline bool region_fits_block(Region_Allocator *region, s64 size) {
+    return (size <= region->block_size) && (size * 2 > region->block_size);
+}
+
+TINYRT_EXTERN ALLOCATOR_PROC(region_allocator_proc) {
+    Region_Allocator *region = (Region_Allocator *)allocator_data;
+    assert(region != null);
+
+    Allocator a = region->fallback;
+    assert(a.proc != null);
+
+    switch (mode) {
+        case ALLOCATOR_ALLOCATE:
+            if (region_fits_block(region, size)) return region_get_block(region);
+            return a.proc(ALLOCATOR_ALLOCATE, size, 0, null, a.data);
+
+        case ALLOCATOR_ALLOCATE_UNINITIALIZED:
+            if (region_fits_block(region, size)) return region_take_block(region, false);
+            return allocator_call(a, ALLOCATOR_ALLOCATE_UNINITIALIZED, size);
+
+        case ALLOCATOR_ALLOCATE_ALIGNED: {
+            // Blocks are only as aligned as the block size allows.
+            s64 block_alignment = region->block_size & -region->block_size;
+            if ((old_size <= block_alignment) && region_fits_block(region, size)) return region_get_block(region);
+
+            return allocator_call(a, ALLOCATOR_ALLOCATE_ALIGNED, size, old_size);
+        } break;
+
+        case ALLOCATOR_RESIZE: {
+            if (!old_memory || !region_owns(region, old_memory)) {
+                return a.proc(ALLOCATOR_RESIZE, size, old_size, old_memory, a.data);
+            }
+
+            if (size <= region->block_size) {
+                if (old_size < size) memory_zero((u8 *)old_memory + old_size, (umm)(size - old_size));
+                return old_memory;
+            }
+
+            void *result = a.proc(ALLOCATOR_ALLOCATE, size, 0, null, a.data);
+            if (!result) return null;
+
+            memcpy(result, old_memory, (umm)Min(old_size, region->block_size));
+            region_free_block(region, old_memory);
+            return result;
+        } break;
+
+        case ALLOCATOR_FREE:
+            if (!old_memory) return null;
+
+            if (region_owns(region, old_memory)) {
+                region_free_block(region, old_memory);
+            } else {
+                a.proc(ALLOCATOR_FREE, 0, 0, old_memory, a.data);
+            }
+            return null;
+
+        case ALLOCATOR_FREE_ALL:
+            region_release(region);
+            return null;
+
+        case ALLOCATOR_CAPS:
+            return (void *)(umm)(ALLOCATOR_CAPS_FREE | ALLOCATOR_CAPS_FREE_ALL | ALLOCATOR_CAPS_RESIZE_IN_PLACE | ALLOCATOR_CAPS_USABLE_SIZE);
+
+        case ALLOCATOR_USABLE_SIZE:
+            if (!old_memory) return null;
+
+            if (region_owns(region, old_memory)) return (void *)(umm)region->block_size;
+            return allocator_call(a, ALLOCATOR_USABLE_SIZE, size, 0, old_memory);
+
+        default:
+            assert(false);
+            return null;
+    }
+}
+
+// Answers the modes past ALLOCATOR_ALLOCATE_ALIGNED, see allocator_call.
+static bool region_allocator_declared = allocator_declare_extended_modes(region_allocator_proc);
+
+#endif  // REGION_IMPLEMENTATION
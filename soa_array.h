@@ -0,0 +1,265 @@
+#ifndef GENERAL_SOA_ARRAY_INCLUDE_H
+#define GENERAL_SOA_ARRAY_INCLUDE_H
+/*
+
+    Structure of arrays.
+
+    Soa_Array<Fields...> keeps every field in its own column, so a loop
+    that reads one or two fields only pulls those through the cache.
+    All columns live in a single allocation, each one starting on its
+    own SOA_COLUMN_ALIGNMENT boundary, and grow together. Columns are
+    plain pointers, loops over them vectorize like loops over any array.
+
+    Fields are picked by index, an enum keeps that readable:
+
+        enum { X, Y, MASS };
+        Soa_Array<float32, float32, float32> particles;
+
+        array_add(&particles, 1.0f, 2.0f, 0.5f);
+
+        float32 *x    = soa_column<X>(&particles);
+        float32 *mass = soa_column<MASS>(&particles);
+        for (s64 index = 0; index < particles.count; ++index) x[index] += mass[index];
+
+        s64 weightless = array_count_matching(soa_column_view<MASS>(&particles), 0.0f);
+
+    Fields are moved around as bytes, they have to be trivially copyable.
+
+*/
+
+#include "general.h"
+#include "array.h"
+
+
+const s64 SOA_COLUMN_ALIGNMENT = 64;  // A cache line, wide enough for any vector load.
+
+template<typename... Fields>
+constexpr bool soa_fields_are_trivial(void) {
+    const bool trivial[] = {std::is_trivially_copyable<Fields>::value...};
+    for (bool it : trivial) {
+        if (!it) return false;
+    }
+
+    return true;
+}
+
+// Type of field I.
+template<s64 I, typename First, typename... Rest>
+struct Soa_Field_Type {
+    typedef typename Soa_Field_Type<I - 1, Rest...>::Type Type;
+};
+
+template<typename First, typename... Rest>
+struct Soa_Field_Type<0, First, Rest...> {
+    typedef First Type;
+};
+
+// Keeps a parameter out of template deduction, array_add takes its values as the fields are.
+template<typename T>
+struct Soa_Value {
+    typedef T Type;
+};
+
+template<typename... Fields>
+struct Soa_Array {
+    static_assert(sizeof...(Fields) > 0, "Soa_Array needs at least one field.");
+    static_assert(soa_fields_are_trivial<Fields...>(), "Soa_Array moves its fields as bytes, they have to be trivially copyable.");
+
+    static const s64 COLUMN_COUNT = sizeof...(Fields);
+
+    s64 allocated = 0;
+    s64 count     = 0;
+
+    void *columns[COLUMN_COUNT] = {};  // All in block, columns[0] is its first aligned byte.
+    void *block = null;                // From the allocator, freed as is.
+
+    Allocator allocator = {heap_allocator, null};
+
+    const Array_Growth *growth = null;  // null grows like ARRAY_GROWTH_DEFAULT.
+};
+
+template<s64 I, typename... Fields>
+TINYRT_INLINE typename Soa_Field_Type<I, Fields...>::Type *soa_column(Soa_Array<Fields...> *soa) {
+    static_assert(I < (s64)sizeof...(Fields), "Soa_Array has no such field.");
+    return (typename Soa_Field_Type<I, Fields...>::Type *)soa->columns[I];
+}
+
+template<s64 I, typename... Fields>
+TINYRT_INLINE Array_View<typename Soa_Field_Type<I, Fields...>::Type> soa_column_view(Soa_Array<Fields...> *soa) {
+    return array_view(soa_column<I>(soa), soa->count);
+}
+
+// Offsets of the columns in a block for capacity items, returns the size of the block.
+template<typename... Fields>
+s64 soa_layout(s64 capacity, s64 *offsets) {
+    const s64 sizes[] = {(s64)size_of(Fields)...};
+
+    s64 offset = 0;
+    for (s64 column = 0; column < (s64)sizeof...(Fields); ++column) {
+        offsets[column] = offset;
+        offset = align_forward(offset + capacity * sizes[column], SOA_COLUMN_ALIGNMENT);
+    }
+
+    return offset;
+}
+
+template<typename... Fields>
+void array_free(Soa_Array<Fields...> *soa) {
+    if (soa->block) {
+        Allocator a = soa->allocator;
+
+        if (!a.proc) {
+            a.proc = heap_allocator;
+            a.data = null;
+        }
+
+        a.proc(ALLOCATOR_FREE, 0, 0, soa->block, a.data);
+    }
+
+    for (s64 column = 0; column < soa->COLUMN_COUNT; ++column) soa->columns[column] = null;
+    soa->block = null;
+
+    soa->count     = 0;
+    soa->allocated = 0;
+}
+
+template<typename... Fields>
+TINYRT_INLINE void array_reset(Soa_Array<Fields...> *soa) {
+    soa->count = 0;
+}
+
+// Every column moves when the block grows, so this is always a fresh
+// block and a copy per column, there is no resizing in place.
+template<typename... Fields>
+void array_reserve(Soa_Array<Fields...> *soa, s64 reserve) {
+    if (reserve <= soa->allocated) return;
+
+    if (!soa->allocator.proc) {
+        soa->allocator.proc = heap_allocator;
+        soa->allocator.data = null;
+    }
+
+    Allocator a = soa->allocator;
+
+    s64 offsets[sizeof...(Fields)];
+    s64 num_bytes = soa_layout<Fields...>(reserve, offsets);
+
+    // Allocators without the extended modes get the block aligned by hand.
+    void *new_block;
+    u8 *block = (u8 *)allocator_alloc_aligned(a, num_bytes, SOA_COLUMN_ALIGNMENT, &new_block);
+    assert(block != null);
+
+    if (!block) return;
+
+    const s64 sizes[] = {(s64)size_of(Fields)...};
+
+    void *old_block = soa->block;
+    soa->block = new_block;
+
+    for (s64 column = 0; column < soa->COLUMN_COUNT; ++column) {
+        if (soa->count) memcpy(block + offsets[column], soa->columns[column], (umm)(soa->count * sizes[column]));
+        soa->columns[column] = block + offsets[column];
+    }
+
+    if (old_block) a.proc(ALLOCATOR_FREE, 0, 0, old_block, a.data);
+
+    // Reserving past maximum_count does not let adds go past it.
+    soa->allocated = reserve;
+    if (soa->growth && (soa->growth->maximum_count >= 0)) {
+        soa->allocated = Min(reserve, Max(soa->growth->maximum_count, soa->count));
+    }
+}
+
+// Makes room for count more rows, false if the array can not grow that far.
+template<typename... Fields>
+bool array_grow(Soa_Array<Fields...> *soa, s64 count) {
+    s64 needed = soa->count + count;
+    if (needed <= soa->allocated) return true;
+
+    const s64 sizes[] = {(s64)size_of(Fields)...};
+
+    s64 row_size = 0;
+    for (s64 size : sizes) row_size += size;
+
+    s64 capacity = array_growth_next_capacity(soa->growth, soa->allocated, needed, row_size);
+    if (capacity < needed) {
+        write_string("Panic: Array grows past its maximum_count.\n", /*bool to_standard_error=*/true);
+        assert(0);
+        return false;
+    }
+
+    array_reserve(soa, capacity);
+    return needed <= soa->allocated;
+}
+
+template<typename... Fields, umm... I>
+TINYRT_INLINE void soa_write_row(Soa_Array<Fields...> *soa, s64 index, std::index_sequence<I...>, const Fields &... values) {
+    int expand[] = {0, (soa_column<I>(soa)[index] = values, 0)...};
+    UNUSED(expand);
+}
+
+// Returns the index of the new row, -1 if the array could not grow.
+template<typename... Fields>
+s64 array_add(Soa_Array<Fields...> *soa, const typename Soa_Value<Fields>::Type &... values) {
+    if (!array_grow(soa, 1)) return -1;
+
+    s64 index = soa->count;
+    soa_write_row(soa, index, std::index_sequence_for<Fields...>(), values...);
+
+    soa->count += 1;
+    return index;
+}
+
+// Adds a zeroed row.
+template<typename... Fields>
+s64 array_add(Soa_Array<Fields...> *soa) {
+    if (!array_grow(soa, 1)) return -1;
+
+    s64 index = soa->count;
+
+    const s64 sizes[] = {(s64)size_of(Fields)...};
+    for (s64 column = 0; column < soa->COLUMN_COUNT; ++column) {
+        memory_zero((u8 *)soa->columns[column] + index * sizes[column], (umm)sizes[column]);
+    }
+
+    soa->count += 1;
+    return index;
+}
+
+// Keeps the order, rows past index move down by one.
+template<typename... Fields>
+void array_ordered_remove_by_index(Soa_Array<Fields...> *soa, s64 index) {
+    assert(index >= 0);
+    assert(index < soa->count);
+
+    const s64 sizes[] = {(s64)size_of(Fields)...};
+    for (s64 column = 0; column < soa->COLUMN_COUNT; ++column) {
+        u8 *data = (u8 *)soa->columns[column];
+        s64 size = sizes[column];
+
+        memmove(data + index * size, data + (index + 1) * size, (umm)((soa->count - index - 1) * size));
+    }
+
+    soa->count -= 1;
+}
+
+// The last row takes the place of the removed one.
+template<typename... Fields>
+void array_unordered_remove_by_index(Soa_Array<Fields...> *soa, s64 index) {
+    assert(index >= 0);
+    assert(index < soa->count);
+
+    s64 last = soa->count - 1;
+
+    const s64 sizes[] = {(s64)size_of(Fields)...};
+    for (s64 column = 0; column < soa->COLUMN_COUNT; ++column) {
+        u8 *data = (u8 *)soa->columns[column];
+        s64 size = sizes[column];
+
+        if (index != last) memcpy(data + index * size, data + last * size, (umm)size);
+    }
+
+    soa->count -= 1;
+}
+
+#endif  // GENERAL_SOA_ARRAY_INCLUDE_H
@@ -0,0 +1,341 @@
+#ifndef GENERAL_THREAD_CACHE_INCLUDE_H
+#define GENERAL_THREAD_CACHE_INCLUDE_H
+/*
+
+    Thread caching allocator front-end.
+
+    Wraps any Allocator, small blocks are recycled through thread local
+    bins so most allocations never touch the parent allocator or a lock.
+    When a bin grows past THREAD_CACHE_BIN_LIMIT a batch of blocks goes
+    back to a central free list shared by every thread.
+
+    Every thread keeps one set of bins, so use a single Thread_Cache per
+    process, and call thread_cache_flush before a thread exits to give its
+    blocks back.
+
+    The central lists are cache line aligned, allocate the cache aligned
+    too. There is no ALLOCATOR_FREE_ALL, the cache does not know which
+    blocks are still live.
+
+
+    To include thread cache implementation as cpp file use:
+
+    #define THREAD_CACHE_IMPLEMENTATION
+    #include "thread_cache.h"
+
+*/
+
+#include "general.h"
+
+
+const s64 THREAD_CACHE_HEADER_SIZE = 16;
+const s64 THREAD_CACHE_CLASS_COUNT = 12;     // Power of two classes from 16 bytes to 32KB.
+const s64 THREAD_CACHE_MAX_SIZE    = KB(32);
+const s64 THREAD_CACHE_BIN_LIMIT   = 64;
+const s64 THREAD_CACHE_BATCH_SIZE  = 32;
+
+typedef struct alignas(64) Thread_Cache_Central_List {  // One cache line per list.
+    Spin_Lock lock;
+    u8 *head;
+    s64 count;
+} Thread_Cache_Central_List;
+
+typedef struct Thread_Cache {
+    Thread_Cache_Central_List central[THREAD_CACHE_CLASS_COUNT];
+
+    Allocator parent = {heap_allocator, null};
+} Thread_Cache;
+
+void thread_cache_init(Thread_Cache *cache, Allocator parent = {heap_allocator, null});
+
+TINYRT_EXTERN void thread_cache_flush(void);
+TINYRT_EXTERN void thread_cache_release(Thread_Cache *cache);
+
+TINYRT_EXTERN ALLOCATOR_PROC(thread_cache_allocator_proc);
+
+#endif  // GENERAL_THREAD_CACHE_INCLUDE_H
+
+
+#if defined(THREAD_CACHE_IMPLEMENTATION) && !defined(THREAD_CACHE_IMPLEMENTATION_INCLUDED)
+#define THREAD_CACHE_IMPLEMENTATION_INCLUDED
+
+// Blocks handed out by the cache are prefixed by this header.
+typedef struct Thread_Cache_Header {
+    s32 size_class;  // -1 for blocks bigger than THREAD_CACHE_MAX_SIZE.
+    s32 alignment;   // Only set for aligned large blocks.
+    s64 offset;      // From the parent block to the header, only set for aligned large blocks.
+} Thread_Cache_Header;
+
+typedef struct Thread_Cache_Bin {
+    u8 *head;
+    s64 count;
+} Thread_Cache_Bin;
+
+typedef struct Thread_Cache_Local {
+    Thread_Cache *owner;
+    Thread_Cache_Bin bins[THREAD_CACHE_CLASS_COUNT];
+} Thread_Cache_Local;
+
+static thread_var Thread_Cache_Local thread_cache_local;
+
+void thread_cache_init(Thread_Cache *cache, Allocator parent) {
+    if (!parent.proc) {
+        parent.proc = heap_allocator;
+        parent.data = null;
+    }
+
+    assert(((umm)cache->central % alignof(Thread_Cache_Central_List)) == 0);
+
+    memory_zero(cache->central, size_of(cache->central));
+    cache->parent = parent;
+}
+
+static inline s64 thread_cache_class_for_size(s64 size) {
+    s64 result = 0;
+    while (((s64)16 << result) < size) result += 1;
+    return result;
+}
+
+// Moves up to count blocks from the front of a bin to the central list.
+static void thread_cache_give_back(Thread_Cache *cache, s64 class_index, s64 count) {
+    Thread_Cache_Bin *bin = &thread_cache_local.bins[class_index];
+    if (!bin->count) return;
+
+    u8 *first = bin->head;
+    u8 *last  = first;
+
+    s64 moved = 1;
+    while ((moved < count) && *(u8 **)last) {
+        last = *(u8 **)last;
+        moved += 1;
+    }
+
+    bin->head   = *(u8 **)last;
+    bin->count -= moved;
+
+    Thread_Cache_Central_List *list = &cache->central[class_index];
+    spin_lock(&list->lock);
+    *(u8 **)last = list->head;
+    list->head   = first;
+    list->count += moved;
+    spin_unlock(&list->lock);
+}
+
+static void thread_cache_take(Thread_Cache *cache, s64 class_index) {
+    Thread_Cache_Central_List *list = &cache->central[class_index];
+    Thread_Cache_Bin *bin = &thread_cache_local.bins[class_index];
+
+    spin_lock(&list->lock);
+    while (list->head && (bin->count < THREAD_CACHE_BATCH_SIZE)) {
+        u8 *block  = list->head;
+        list->head = *(u8 **)block;
+        list->count -= 1;
+
+        *(u8 **)block = bin->head;
+        bin->head     = block;
+        bin->count   += 1;
+    }
+    spin_unlock(&list->lock);
+}
+
+TINYRT_EXTERN void thread_cache_flush(void) {
+    Thread_Cache *owner = thread_cache_local.owner;
+    if (!owner) return;
+
+    for (s64 index = 0; index < THREAD_CACHE_CLASS_COUNT; ++index) {
+        thread_cache_give_back(owner, index, thread_cache_local.bins[index].count);
+    }
+
+    thread_cache_local.owner = null;
+}
+
+// Frees every block of the central lists, other threads must have flushed already.
+TINYRT_EXTERN void thread_cache_release(Thread_Cache *cache) {
+    if (thread_cache_local.owner == cache) thread_cache_flush();
+
+    Allocator a = cache->parent;
+    assert(a.proc != null);
+
+    for (s64 index = 0; index < THREAD_CACHE_CLASS_COUNT; ++index) {
+        Thread_Cache_Central_List *list = &cache->central[index];
+
+        spin_lock(&list->lock);
+        while (list->head) {
+            u8 *block  = list->head;
+            list->head = *(u8 **)block;
+            a.proc(ALLOCATOR_FREE, 0, 0, block, a.data);
+        }
+        list->count = 0;
+        spin_unlock(&list->lock);
+    }
+}
+
+static void *thread_cache_get(Thread_Cache *cache, s64 size, bool zero = true) {
+    Allocator a = cache->parent;
+    Allocator_Mode parent_mode = zero ? ALLOCATOR_ALLOCATE : ALLOCATOR_ALLOCATE_UNINITIALIZED;
+
+    if (size > THREAD_CACHE_MAX_SIZE) {
+        Thread_Cache_Header *header = (Thread_Cache_Header *)allocator_call(a, parent_mode, size + THREAD_CACHE_HEADER_SIZE);
+        if (!header) return null;
+
+        header->size_class = -1;
+        header->alignment  = 0;
+        header->offset     = 0;
+        return header + 1;
+    }
+
+    if (thread_cache_local.owner != cache) {
+        thread_cache_flush();
+        thread_cache_local.owner = cache;
+    }
+
+    s64 class_index = thread_cache_class_for_size(size);
+    Thread_Cache_Bin *bin = &thread_cache_local.bins[class_index];
+
+    if (!bin->head) thread_cache_take(cache, class_index);
+
+    if (!bin->head) {
+        s64 block_size = ((s64)16 << class_index) + THREAD_CACHE_HEADER_SIZE;
+
+        Thread_Cache_Header *header = (Thread_Cache_Header *)allocator_call(a, parent_mode, block_size);
+        if (!header) return null;
+
+        header->size_class = (s32)class_index;
+        return header + 1;
+    }
+
+    Thread_Cache_Header *header = (Thread_Cache_Header *)bin->head;
+    bin->head   = *(u8 **)header;
+    bin->count -= 1;
+
+    header->size_class = (s32)class_index;
+
+    // Recycled blocks are dirty, zero them like the parent would.
+    if (zero) memory_zero(header + 1, (umm)size);
+    return header + 1;
+}
+
+// Every class is a power of two past a 16 byte header, so only bigger
+// alignments need a large block from the parent.
+static void *thread_cache_get_aligned(Thread_Cache *cache, s64 size, s64 alignment) {
+    if (alignment <= THREAD_CACHE_HEADER_SIZE) return thread_cache_get(cache, size);
+
+    void *base;
+    u8 *block = (u8 *)allocator_alloc_aligned(cache->parent, size + alignment, alignment, &base);
+    if (!block) return null;
+
+    Thread_Cache_Header *header = (Thread_Cache_Header *)(block + alignment) - 1;
+    header->size_class = -1;
+    header->alignment  = (s32)alignment;
+    header->offset     = (u8 *)header - (u8 *)base;
+    return header + 1;
+}
+
+static void thread_cache_put(Thread_Cache *cache, void *memory) {
+    Thread_Cache_Header *header = (Thread_Cache_Header *)memory - 1;
+
+    if (header->size_class < 0) {
+        Allocator a = cache->parent;
+        a.proc(ALLOCATOR_FREE, 0, 0, (u8 *)header - header->offset, a.data);
+        return;
+    }
+
+    if (thread_cache_local.owner != cache) {
+        thread_cache_flush();
+        thread_cache_local.owner = cache;
+    }
+
+    s64 class_index = header->size_class;
+    Thread_Cache_Bin *bin = &thread_cache_local.bins[class_index];
+
+    *(u8 **)header = bin->head;
+    bin->head      = (u8 *)header;
+    bin->count    += 1;
+
+    if (bin->count > THREAD_CACHE_BIN_LIMIT) {
+        thread_cache_give_back(cache, class_index, THREAD_CACHE_BATCH_SIZE);
+    }
+}
+
+TINYRT_EXTERN ALLOCATOR_PROC(thread_cache_allocator_proc) {
+    Thread_Cache *cache = (Thread_Cache *)allocator_data;
+    assert(cache != null);
+    assert(cache->parent.proc != null);
+
+    switch (mode) {
+        case ALLOCATOR_ALLOCATE:
+            return thread_cache_get(cache, size);
+
+        case ALLOCATOR_ALLOCATE_UNINITIALIZED:
+            return thread_cache_get(cache, size, false);
+
+        case ALLOCATOR_ALLOCATE_ALIGNED:
+            return thread_cache_get_aligned(cache, size, old_size);
+
+        case ALLOCATOR_RESIZE: {
+            if (!old_memory) return thread_cache_get(cache, size);
+
+            Thread_Cache_Header *header = (Thread_Cache_Header *)old_memory - 1;
+
+            if ((header->size_class < 0) && !header->alignment && (size > THREAD_CACHE_MAX_SIZE)) {
+                Allocator a = cache->parent;
+
+                header = (Thread_Cache_Header *)a.proc(ALLOCATOR_RESIZE, size + THREAD_CACHE_HEADER_SIZE,
+                                                       old_size + THREAD_CACHE_HEADER_SIZE, header, a.data);
+                if (!header) return null;
+
+                return header + 1;
+            }
+
+            s64 capacity = (header->size_class < 0) ? old_size : ((s64)16 << header->size_class);
+            if ((header->size_class >= 0) && (size <= capacity)) {
+                if (old_size < size) memory_zero((u8 *)old_memory + old_size, (umm)(size - old_size));
+                return old_memory;
+            }
+
+            void *result;
+            if ((header->size_class < 0) && header->alignment) {
+                result = thread_cache_get_aligned(cache, size, header->alignment);
+            } else {
+                result = thread_cache_get(cache, size);
+            }
+            if (!result) return null;
+
+            memcpy(result, old_memory, (umm)Min(Min(old_size, capacity), size));
+            thread_cache_put(cache, old_memory);
+            return result;
+        } break;
+
+        case ALLOCATOR_FREE:
+            if (old_memory) thread_cache_put(cache, old_memory);
+            return null;
+
+        case ALLOCATOR_FREE_ALL:
+            // Not supported, live blocks and other threads' bins are not tracked.
+            assert(!"Not supported");
+            return null;
+
+        case ALLOCATOR_CAPS:
+            return (void *)(umm)(ALLOCATOR_CAPS_FREE | ALLOCATOR_CAPS_RESIZE_IN_PLACE |
+                                 ALLOCATOR_CAPS_USABLE_SIZE | ALLOCATOR_CAPS_ZEROED);
+
+        case ALLOCATOR_USABLE_SIZE: {
+            if (!old_memory) return null;
+
+            // Large blocks would need the parent to look past our header, keep it simple.
+            Thread_Cache_Header *header = (Thread_Cache_Header *)old_memory - 1;
+            if (header->size_class < 0) return null;
+
+            return (void *)(umm)((s64)16 << header->size_class);
+        } break;
+
+        default:
+            assert(false);
+            return null;
+    }
+}
+
+// Answers the modes past ALLOCATOR_ALLOCATE_ALIGNED, see allocator_call.
+static bool thread_cache_allocator_declared = allocator_declare_extended_modes(thread_cache_allocator_proc);
+
+#endif  // THREAD_CACHE_IMPLEMENTATION